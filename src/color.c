@@ -17,7 +17,7 @@
  * Copyright (C) 2008-2019, Victor Ananjevsky <ananasik@gmail.com>
  */
 
-#include <errno.h>
+#include <string.h>
 
 #include "yad.h"
 #if GTK_CHECK_VERSION(3,0,0)
@@ -26,76 +26,119 @@
 
 static GtkWidget *color;
 
+enum {
+  PALETTE_SPEC,
+  PALETTE_NAME,
+  PALETTE_KEY,
+  PALETTE_COLUMNS
+};
+
+static GtkTreeModel *filter = NULL;
+static gchar *filter_key = NULL;
+
+/* read color number from palette line. returns position after number or NULL on error */
+static const gchar *
+parse_number (const gchar *p, const gchar *end, gint *val)
+{
+  while (p < end && (*p == ' ' || *p == '\t'))
+    p++;
+
+  if (p == end || !g_ascii_isdigit (*p))
+    return NULL;
+
+  *val = 0;
+  while (p < end && g_ascii_isdigit (*p))
+    {
+      *val = *val * 10 + (*p - '0');
+      p++;
+    }
+
+  return p;
+}
+
 static GtkTreeModel *
 create_palette ()
 {
-  FILE *fp;
+  GMappedFile *map;
   gchar *filename;
-  gchar buf[1024], *name;
+  const gchar *p, *end;
   GtkListStore *store;
-  GdkPixbuf *pb;
-  GtkTreeIter iter;
-
-  gchar *cxpm[] = {
-    "16 14 1 1",
-    ". c #FFFFFF",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................",
-    "................"
-  };
-  gchar cl[] = ". c #FFFFFF";
+  GError *err = NULL;
 
   if (options.color_data.palette)
     filename = options.color_data.palette;
   else
     filename = RGB_FILE;
 
-  if ((fp = fopen (filename, "r")) == NULL)
+  if ((map = g_mapped_file_new (filename, FALSE, &err)) == NULL)
     {
-      g_printerr (_("Can't open file %s: %s\n"), filename, strerror (errno));
+      g_printerr (_("Can't open file %s: %s\n"), filename, err->message);
+      g_error_free (err);
       return NULL;
     }
 
-  store = gtk_list_store_new (3, GDK_TYPE_PIXBUF, G_TYPE_STRING, G_TYPE_STRING);
+  store = gtk_list_store_new (PALETTE_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
 
-  while ((name = fgets (buf, sizeof (buf), fp)) != NULL)
+  /* parse file in one pass */
+  p = g_mapped_file_get_contents (map);
+  end = p + g_mapped_file_get_length (map);
+  while (p < end)
     {
+      const gchar *eol, *n;
       gint r, g, b;
-      gchar spec[8];
 
-      if (buf[0] == '!')
-        continue;
+      eol = memchr (p, '\n', end - p);
+      if (!eol)
+        eol = end;
+
+      if (*p != '!' && (n = parse_number (p, eol, &r)) && (n = parse_number (n, eol, &g)) && (n = parse_number (n, eol, &b)))
+        {
+          gchar spec[8], *name, *key;
 
-      sscanf (buf, "%d %d %d", &r, &g, &b);
+          g_snprintf (spec, sizeof (spec), "#%.2X%.2X%.2X", r & 0xff, g & 0xff, b & 0xff);
 
-      g_sprintf (spec, "#%.2X%.2X%.2X", r, g, b);
-      g_sprintf (cl, ". c #%.2X%.2X%.2X", r, g, b);
-      cxpm[1] = cl;
-      pb = gdk_pixbuf_new_from_xpm_data ((const gchar **) cxpm);
+          name = g_strstrip (g_strndup (n, eol - n));
+          key = fold_str (name);
 
-      while (g_ascii_isdigit (*name) || g_ascii_isspace (*name))
-        name++;
+          gtk_list_store_insert_with_values (store, NULL, -1, PALETTE_SPEC, spec, PALETTE_NAME, name, PALETTE_KEY, key, -1);
 
-      gtk_list_store_append (store, &iter);
-      gtk_list_store_set (store, &iter, 0, pb, 1, spec, 2, g_strstrip (name), -1);
+          g_free (name);
+          g_free (key);
+        }
+
+      p = eol + 1;
     }
 
-  fclose (fp);
+  g_mapped_file_unref (map);
 
   return GTK_TREE_MODEL (store);
 }
 
+static gboolean
+palette_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+  gchar *key, *spec;
+  gboolean res;
+
+  if (!filter_key || !filter_key[0])
+    return TRUE;
+
+  gtk_tree_model_get (model, iter, PALETTE_SPEC, &spec, PALETTE_KEY, &key, -1);
+  res = (key && strstr (key, filter_key)) || (spec && g_ascii_strncasecmp (spec, filter_key, strlen (filter_key)) == 0);
+  g_free (key);
+  g_free (spec);
+
+  return res;
+}
+
+static void
+search_changed (GtkEntry *e, gpointer data)
+{
+  g_free (filter_key);
+  filter_key = fold_str (gtk_entry_get_text (e));
+  gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+}
+
 static void
 set_color (gchar *clr)
 {
@@ -127,8 +170,9 @@ palette_changed (GtkTreeSelection * sel, gpointer data)
   if (gtk_tree_selection_get_selected (sel, &model, &iter))
     {
       gchar *clr;
-      gtk_tree_model_get (model, &iter, 1, &clr, -1);
+      gtk_tree_model_get (model, &iter, PALETTE_SPEC, &clr, -1);
       set_color (clr);
+      g_free (clr);
     }
 }
 
@@ -178,7 +222,8 @@ color_create_widget (GtkWidget * dlg)
 
       if ((model = create_palette ()) != NULL)
         {
-          GtkWidget *exp, *sw, *list;
+          GtkWidget *exp, *box, *entry, *sw, *list;
+          GtkTreeModel *sorted;
           GtkCellRenderer *r;
           GtkTreeViewColumn *col;
           GtkTreeSelection *sel;
@@ -189,45 +234,70 @@ color_create_widget (GtkWidget * dlg)
           gtk_container_set_border_width (GTK_CONTAINER (exp), 5);
           gtk_box_pack_start (GTK_BOX (w), exp, TRUE, TRUE, 2);
 
+#if !GTK_CHECK_VERSION(3,0,0)
+          box = gtk_vbox_new (FALSE, 2);
+#else
+          box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 2);
+#endif
+          gtk_container_add (GTK_CONTAINER (exp), box);
+
+          /* create search entry */
+#if GTK_CHECK_VERSION(3,6,0)
+          entry = gtk_search_entry_new ();
+#else
+          entry = gtk_entry_new ();
+#endif
+          gtk_widget_set_name (entry, "yad-color-search");
+          gtk_box_pack_start (GTK_BOX (box), entry, FALSE, FALSE, 0);
+          g_signal_connect (G_OBJECT (entry), "changed", G_CALLBACK (search_changed), NULL);
+
           /* create color list */
           sw = gtk_scrolled_window_new (NULL, NULL);
           gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (sw), GTK_SHADOW_ETCHED_IN);
           gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (sw), options.hscroll_policy, options.vscroll_policy);
           gtk_widget_set_size_request (sw, -1, 75);
-          gtk_container_add (GTK_CONTAINER (exp), sw);
+          gtk_box_pack_start (GTK_BOX (box), sw, TRUE, TRUE, 0);
 #if GTK_CHECK_VERSION(3,0,0)
           gtk_widget_set_vexpand (sw, TRUE);
 #endif
-          list = gtk_tree_view_new_with_model (model);
-          gtk_widget_set_name (list, "yad-color-palette");
+          /* filter palette by search string. sorting goes on top of filter */
+          filter = gtk_tree_model_filter_new (model, NULL);
+          gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter), palette_visible, NULL, NULL);
           g_object_unref (model);
+          sorted = gtk_tree_model_sort_new_with_model (filter);
+          g_object_unref (filter);
+
+          list = gtk_tree_view_new_with_model (sorted);
+          gtk_widget_set_name (list, "yad-color-palette");
+          g_object_unref (sorted);
           gtk_container_add (GTK_CONTAINER (sw), list);
 
           /* add first columns */
           col = gtk_tree_view_column_new ();
           gtk_tree_view_column_set_title (col, _("Color"));
 
-          /* pixbuf */
-          r = gtk_cell_renderer_pixbuf_new ();
+          /* color swatch. renderer just paints its background */
+          r = gtk_cell_renderer_text_new ();
+          gtk_cell_renderer_set_fixed_size (r, 16, 14);
           gtk_tree_view_column_pack_start (col, r, FALSE);
-          gtk_tree_view_column_set_attributes (col, r, "pixbuf", 0, NULL);
+          gtk_tree_view_column_set_attributes (col, r, "cell-background", PALETTE_SPEC, NULL);
 
           /* color value */
           r = gtk_cell_renderer_text_new ();
           gtk_tree_view_column_pack_start (col, r, TRUE);
-          gtk_tree_view_column_set_attributes (col, r, "text", 1, NULL);
+          gtk_tree_view_column_set_attributes (col, r, "text", PALETTE_SPEC, NULL);
 
-          gtk_tree_view_column_set_sort_column_id (col, 1);
+          gtk_tree_view_column_set_sort_column_id (col, PALETTE_SPEC);
           gtk_tree_view_append_column (GTK_TREE_VIEW (list), col);
 
           /* add second column */
           r = gtk_cell_renderer_text_new ();
-          col = gtk_tree_view_column_new_with_attributes (_("Name"), r, "text", 2, NULL);
-          gtk_tree_view_column_set_sort_column_id (col, 2);
+          col = gtk_tree_view_column_new_with_attributes (_("Name"), r, "text", PALETTE_NAME, NULL);
+          gtk_tree_view_column_set_sort_column_id (col, PALETTE_NAME);
           gtk_tree_view_append_column (GTK_TREE_VIEW (list), col);
 
-          /* enable searching on Name column */
-          gtk_tree_view_set_search_column (GTK_TREE_VIEW (list), 2);
+          /* search entry replaces interactive search */
+          gtk_tree_view_set_enable_search (GTK_TREE_VIEW (list), FALSE);
 
           /* setup the selection handler */
           sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list));
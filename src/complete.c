@@ -0,0 +1,487 @@
+/*
+ * This file is part of YAD.
+ *
+ * YAD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YAD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YAD. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2008-2019, Victor Ananjevsky <ananasik@gmail.com>
+ */
+
+#include <string.h>
+
+#include "yad.h"
+
+/* items model columns: text, id (for GtkComboBoxText) and item number */
+#define ITEM_NUM_COLUMN 2
+
+#define TRIGRAM(s) GUINT_TO_POINTER (((guint) (guchar) (s)[0] << 16) | \
+                                     ((guint) (guchar) (s)[1] << 8) | (guint) (guchar) (s)[2])
+
+typedef struct {
+  gchar *src;           /* source string (key in cache) or NULL */
+  gint def;             /* default item */
+  GPtrArray *texts;     /* case-folded items */
+  GHashTable *index;    /* trigram -> array of item numbers */
+  guint *sorted;        /* item numbers sorted by text, for prefix search */
+  YadMatcher *matcher;  /* matcher for last filter key */
+  guint8 *found;        /* filter result */
+  guint *cand;          /* numbers of found items */
+  guint n_cand;
+} YadItems;
+
+/* shared models by source string */
+static GHashTable *items_cache = NULL;
+
+/* normalize and case-fold string for comparisons */
+gchar *
+fold_str (const gchar *str)
+{
+  gchar *norm, *res;
+
+  norm = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
+  if (!norm)
+    return g_strdup (str);
+  res = g_utf8_casefold (norm, -1);
+  g_free (norm);
+
+  return res;
+}
+
+static void
+free_posting (GArray *a)
+{
+  g_array_free (a, TRUE);
+}
+
+static void
+free_items (YadItems *it)
+{
+  if (it->src)
+    {
+      g_hash_table_remove (items_cache, it->src);
+      g_free (it->src);
+    }
+  g_ptr_array_free (it->texts, TRUE);
+  if (it->index)
+    g_hash_table_destroy (it->index);
+  g_free (it->sorted);
+  if (it->matcher)
+    matcher_free (it->matcher);
+  g_free (it->found);
+  g_free (it->cand);
+  g_free (it);
+}
+
+static void
+build_index (YadItems *it)
+{
+  guint i;
+
+  it->index = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) free_posting);
+
+  for (i = 0; i < it->texts->len; i++)
+    {
+      const gchar *p = g_ptr_array_index (it->texts, i);
+
+      for (; p[0] && p[1] && p[2]; p++)
+        {
+          GArray *a = g_hash_table_lookup (it->index, TRIGRAM (p));
+
+          if (!a)
+            {
+              a = g_array_new (FALSE, FALSE, sizeof (guint));
+              g_hash_table_insert (it->index, TRIGRAM (p), a);
+            }
+          /* add each item only once */
+          if (a->len == 0 || g_array_index (a, guint, a->len - 1) != i)
+            g_array_append_val (a, i);
+        }
+    }
+}
+
+static gint
+cmp_items (gconstpointer a, gconstpointer b, gpointer data)
+{
+  GPtrArray *texts = (GPtrArray *) data;
+
+  return strcmp (g_ptr_array_index (texts, *(guint *) a), g_ptr_array_index (texts, *(guint *) b));
+}
+
+static void
+build_sorted (YadItems *it)
+{
+  guint i;
+
+  it->sorted = g_new (guint, it->texts->len);
+  for (i = 0; i < it->texts->len; i++)
+    it->sorted[i] = i;
+  g_qsort_with_data (it->sorted, it->texts->len, sizeof (guint), cmp_items, it->texts);
+}
+
+/* mark items which starts with key */
+static void
+mark_prefix (YadItems *it, const gchar *key)
+{
+  guint lo = 0, hi = it->texts->len, len = strlen (key);
+
+  if (!it->sorted)
+    build_sorted (it);
+
+  /* find first item not less than key */
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (strcmp (g_ptr_array_index (it->texts, it->sorted[mid]), key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  for (; lo < it->texts->len; lo++)
+    {
+      guint n = it->sorted[lo];
+
+      if (strncmp (g_ptr_array_index (it->texts, n), key, len) != 0)
+        break;
+      it->found[n] = 1;
+    }
+}
+
+/* mark items which contains word */
+static void
+mark_word (YadItems *it, const gchar *word)
+{
+  guint i;
+
+  if (strlen (word) >= 3)
+    {
+      GArray *best = NULL;
+      const gchar *p;
+
+      if (!it->index)
+        build_index (it);
+
+      /* check only items from the shortest trigram list */
+      for (p = word; p[2]; p++)
+        {
+          GArray *a = g_hash_table_lookup (it->index, TRIGRAM (p));
+
+          /* no items with this trigram */
+          if (!a)
+            return;
+          if (!best || a->len < best->len)
+            best = a;
+        }
+
+      for (i = 0; i < best->len; i++)
+        {
+          guint n = g_array_index (best, guint, i);
+
+          if (strstr (g_ptr_array_index (it->texts, n), word))
+            it->found[n] = 1;
+        }
+    }
+  else
+    {
+      /* too short for index */
+      for (i = 0; i < it->texts->len; i++)
+        {
+          if (strstr (g_ptr_array_index (it->texts, i), word))
+            it->found[i] = 1;
+        }
+    }
+}
+
+/* create matcher for completion key. key is split or compiled only once */
+YadMatcher *
+matcher_new (const gchar *key)
+{
+  YadMatcher *m;
+  gchar **w;
+  guint i;
+
+  m = g_new0 (YadMatcher, 1);
+  m->type = options.common_data.complete;
+  m->key = g_strdup (key);
+  m->fkey = fold_str (key);
+
+  switch (m->type)
+    {
+    case YAD_COMPLETE_ANY:
+    case YAD_COMPLETE_ALL:
+      /* keep only non-empty words */
+      w = g_strsplit_set (m->fkey, " \t", -1);
+      m->words = g_new0 (gchar *, g_strv_length (w) + 1);
+      for (i = 0; w[i]; i++)
+        {
+          if (w[i][0])
+            m->words[m->n_words++] = w[i];
+          else
+            g_free (w[i]);
+        }
+      g_free (w);
+      break;
+    case YAD_COMPLETE_REGEX:
+      m->regex = g_regex_new (key, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, G_REGEX_MATCH_NOTEMPTY, NULL);
+      break;
+    default: ;
+    }
+
+  return m;
+}
+
+void
+matcher_free (YadMatcher *m)
+{
+  g_free (m->key);
+  g_free (m->fkey);
+  g_strfreev (m->words);
+  if (m->regex)
+    g_regex_unref (m->regex);
+  g_free (m);
+}
+
+/* check case-folded text */
+gboolean
+matcher_match (YadMatcher *m, const gchar *text)
+{
+  guint i;
+
+  switch (m->type)
+    {
+    case YAD_COMPLETE_ANY:
+      if (m->n_words == 0)
+        return TRUE;
+      for (i = 0; i < m->n_words; i++)
+        {
+          if (strstr (text, m->words[i]))
+            return TRUE;
+        }
+      return FALSE;
+    case YAD_COMPLETE_ALL:
+      for (i = 0; i < m->n_words; i++)
+        {
+          if (!strstr (text, m->words[i]))
+            return FALSE;
+        }
+      return TRUE;
+    case YAD_COMPLETE_REGEX:
+      return m->regex && g_regex_match (m->regex, text, 0, NULL);
+    default:
+      return g_str_has_prefix (text, m->fkey);
+    }
+}
+
+/* check if everything matched by m is matched by old too */
+static gboolean
+matcher_narrows (YadMatcher *old, YadMatcher *m)
+{
+  if (!g_str_has_prefix (m->fkey, old->fkey))
+    return FALSE;
+
+  switch (m->type)
+    {
+    case YAD_COMPLETE_ANY:
+      /* new word extends the set of matches */
+      return m->n_words == old->n_words;
+    case YAD_COMPLETE_REGEX:
+      return FALSE;
+    default:
+      return TRUE;
+    }
+}
+
+static void
+filter_items (YadItems *it, const gchar *key)
+{
+  YadMatcher *m;
+  guint i, n = it->texts->len;
+
+  m = matcher_new (key);
+
+  if (it->matcher && matcher_narrows (it->matcher, m))
+    {
+      guint k = 0;
+
+      /* key was extended, check only previously found items */
+      for (i = 0; i < it->n_cand; i++)
+        {
+          guint c = it->cand[i];
+
+          if (matcher_match (m, g_ptr_array_index (it->texts, c)))
+            it->cand[k++] = c;
+          else
+            it->found[c] = 0;
+        }
+      it->n_cand = k;
+    }
+  else
+    {
+      memset (it->found, 0, n);
+
+      switch (m->type)
+        {
+        case YAD_COMPLETE_ANY:
+          if (m->n_words == 0)
+            memset (it->found, 1, n);
+          for (i = 0; i < m->n_words; i++)
+            mark_word (it, m->words[i]);
+          break;
+        case YAD_COMPLETE_ALL:
+          if (m->n_words == 0)
+            memset (it->found, 1, n);
+          else
+            {
+              guint best = 0;
+
+              /* start from the longest word, it gives the shortest list */
+              for (i = 1; i < m->n_words; i++)
+                {
+                  if (strlen (m->words[i]) > strlen (m->words[best]))
+                    best = i;
+                }
+              mark_word (it, m->words[best]);
+
+              if (m->n_words > 1)
+                {
+                  for (i = 0; i < n; i++)
+                    {
+                      if (it->found[i] && !matcher_match (m, g_ptr_array_index (it->texts, i)))
+                        it->found[i] = 0;
+                    }
+                }
+            }
+          break;
+        case YAD_COMPLETE_REGEX:
+          /* regex can't be checked with index */
+          for (i = 0; i < n; i++)
+            it->found[i] = matcher_match (m, g_ptr_array_index (it->texts, i));
+          break;
+        default:
+          mark_prefix (it, m->fkey);
+        }
+
+      it->n_cand = 0;
+      for (i = 0; i < n; i++)
+        {
+          if (it->found[i])
+            it->cand[it->n_cand++] = i;
+        }
+    }
+
+  if (it->matcher)
+    matcher_free (it->matcher);
+  it->matcher = m;
+}
+
+static GtkTreeModel *
+new_items_model (gchar **items, YadItems *it)
+{
+  GtkListStore *store;
+  guint i;
+
+  store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_UINT);
+
+  it->texts = g_ptr_array_new_with_free_func (g_free);
+  for (i = 0; items[i]; i++)
+    {
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, items[i], ITEM_NUM_COLUMN, i, -1);
+      g_ptr_array_add (it->texts, fold_str (items[i]));
+    }
+  it->found = g_new0 (guint8, i + 1);
+  it->cand = g_new0 (guint, i + 1);
+
+  g_object_set_data_full (G_OBJECT (store), "yad-items", it, (GDestroyNotify) free_items);
+
+  return GTK_TREE_MODEL (store);
+}
+
+/* create model for completion or combo-box from array of items */
+GtkTreeModel *
+create_items_model (gchar **items)
+{
+  YadItems *it = g_new0 (YadItems, 1);
+
+  it->def = -1;
+  return new_items_model (items, it);
+}
+
+/* get model for completion or combo-box from the list of items separated with item separator.
+ * default item is marked with '^'. models for the same list are shared */
+GtkTreeModel *
+get_items_model (const gchar *str, gint *def)
+{
+  YadItems *it;
+  GtkTreeModel *m;
+  gchar **s;
+  guint i;
+
+  if (!items_cache)
+    items_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  m = g_hash_table_lookup (items_cache, str);
+  if (m)
+    {
+      it = g_object_get_data (G_OBJECT (m), "yad-items");
+      *def = it->def;
+      return g_object_ref (m);
+    }
+
+  it = g_new0 (YadItems, 1);
+  it->src = g_strdup (str);
+  it->def = -1;
+
+  s = g_strsplit (str, options.common_data.item_separator, -1);
+  for (i = 0; s[i]; i++)
+    {
+      gchar *buf;
+
+      if (s[i][0] == '^')
+        {
+          buf = g_strcompress (s[i] + 1);
+          it->def = i;
+        }
+      else
+        buf = g_strcompress (s[i]);
+      g_free (s[i]);
+      s[i] = buf;
+    }
+
+  m = new_items_model (s, it);
+  g_strfreev (s);
+
+  g_hash_table_insert (items_cache, it->src, m);
+
+  *def = it->def;
+  return m;
+}
+
+/* check item with current key using index of items model */
+gboolean
+items_match (GtkTreeModel *model, const gchar *key, GtkTreeIter *iter)
+{
+  YadItems *it;
+  guint n;
+
+  it = g_object_get_data (G_OBJECT (model), "yad-items");
+  if (!it)
+    return FALSE;
+
+  if (!it->matcher || strcmp (key, it->matcher->key) != 0)
+    filter_items (it, key);
+
+  gtk_tree_model_get (model, iter, ITEM_NUM_COLUMN, &n, -1);
+
+  return n < it->texts->len && it->found[n];
+}
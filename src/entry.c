@@ -84,28 +84,6 @@ icon_cb (GtkEntry * entry, GtkEntryIconPosition pos, GdkEventButton * event, gpo
     }
 }
 
-static GtkTreeModel *
-create_completion_model (void)
-{
-  GtkListStore *store;
-  GtkTreeIter iter;
-  gint i = 0;
-
-  store = gtk_list_store_new (1, G_TYPE_STRING);
-
-  if (options.extra_data)
-    {
-      while (options.extra_data[i] != NULL)
-        {
-          gtk_list_store_append (store, &iter);
-          gtk_list_store_set (store, &iter, 0, options.extra_data[i], -1);
-          i++;
-        }
-    }
-
-  return GTK_TREE_MODEL (store);
-}
-
 GtkWidget *
 entry_create_widget (GtkWidget * dlg)
 {
@@ -260,14 +238,18 @@ entry_create_widget (GtkWidget * dlg)
           completion = gtk_entry_completion_new ();
           gtk_entry_set_completion (GTK_ENTRY (entry), completion);
 
-          completion_model = create_completion_model ();
+          if (options.extra_data)
+            completion_model = create_items_model (options.extra_data);
+          else
+            {
+              gchar *empty[] = { NULL };
+              completion_model = create_items_model (empty);
+            }
           gtk_entry_completion_set_model (completion, completion_model);
           g_object_unref (completion_model);
 
           gtk_entry_completion_set_text_column (completion, 0);
-
-          if (options.common_data.complete != YAD_COMPLETE_SIMPLE)
-            gtk_entry_completion_set_match_func (completion, check_complete, NULL, NULL);
+          gtk_entry_completion_set_match_func (completion, check_complete, NULL, NULL);
 
           g_object_unref (completion);
         }
@@ -113,6 +113,11 @@ file_create_widget (GtkWidget * dlg)
       GtkWidget *p = gtk_image_new ();
       gtk_file_chooser_set_preview_widget (GTK_FILE_CHOOSER (w), p);
       g_signal_connect (w, "update-preview", G_CALLBACK (update_preview), p);
+      if (options.common_data.prefetch_preview)
+        {
+          g_signal_connect (w, "current-folder-changed", G_CALLBACK (prefetch_previews), NULL);
+          prefetch_previews (GTK_FILE_CHOOSER (w), NULL);
+        }
     }
 
   /* add filters */
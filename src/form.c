@@ -127,17 +127,275 @@ preprocess_atid (gchar *text, gchar *format, gchar **result)
   return *result != text;
 }
 
-/* expand %N in command to fields values */
-static GString *
-expand_action (gchar *command)
+typedef gchar * (*FieldArgFunc) (GtkWidget *w);
+
+/* pre-parsed action token: either literal text or reference to a form field */
+typedef struct {
+  gchar *text;
+  FieldArgFunc get_arg;
+  GtkWidget *w;
+} ActionToken;
+
+/* delay for coalescing bursts of changes (ms) */
+#define CHANGED_ACTION_DELAY 150
+
+/* state of changed action for each field */
+typedef struct {
+  GPtrArray *tpl;
+  guint timer;
+  gboolean running;
+  gboolean pending;
+  gchar *run_cmd;               /* command which runs now */
+  gchar *last_cmd;              /* command which output was applied last */
+  guint last_serial;
+} ChangedAction;
+
+static ChangedAction *changed = NULL;
+/* increased on every external change of fields values */
+static guint set_serial = 0;
+
+/* last values set to fields and pending keyed updates */
+static gchar **values = NULL;
+static gchar **batch = NULL;
+static gchar **shown = NULL;    /* widgets values right after keyed updates */
+static GSList *batch_ids = NULL;
+static GHashTable *atids = NULL;
+
+static gchar *
+entry_arg (GtkWidget *w)
 {
-  GString *xcmd;
+  gchar *buf, *arg;
+
+  buf = escape_char ((gchar *) gtk_entry_get_text (GTK_ENTRY (w)), '"');
+  arg = g_shell_quote (buf ? buf : "");
+  g_free (buf);
+
+  return arg;
+}
+
+static gchar *
+num_arg (GtkWidget *w)
+{
+  guint prec = gtk_spin_button_get_digits (GTK_SPIN_BUTTON (w));
+  return g_strdup_printf ("%.*f", prec, gtk_spin_button_get_value (GTK_SPIN_BUTTON (w)));
+}
+
+static gchar *
+check_arg (GtkWidget *w)
+{
+  return g_strdup (print_bool_val (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (w))));
+}
+
+#if GTK_CHECK_VERSION(3,0,0)
+static gchar *
+switch_arg (GtkWidget *w)
+{
+  return g_strdup (print_bool_val (gtk_switch_get_state (GTK_SWITCH (w))));
+}
+#endif
+
+static gchar *
+combo_arg (GtkWidget *w)
+{
+  gchar *buf, *arg;
+
+  buf = gtk_combo_box_text_get_active_text (GTK_COMBO_BOX_TEXT (w));
+  arg = g_shell_quote (buf ? buf : "");
+  g_free (buf);
+
+  return arg;
+}
+
+static gchar *
+scale_arg (GtkWidget *w)
+{
+  return g_strdup_printf ("%d", (gint) gtk_range_get_value (GTK_RANGE (w)));
+}
+
+static gchar *
+file_arg (GtkWidget *w)
+{
+  gchar *buf, *arg;
+
+  buf = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (w));
+  arg = g_shell_quote (buf ? buf : "");
+  g_free (buf);
+
+  return arg;
+}
+
+static gchar *
+font_arg (GtkWidget *w)
+{
+#if !GTK_CHECK_VERSION(3,2,0)
+  return g_shell_quote (gtk_font_button_get_font_name (GTK_FONT_BUTTON (w)));
+#else
+  gchar *buf, *arg;
+
+  buf = gtk_font_chooser_get_font (GTK_FONT_CHOOSER (w));
+  arg = g_shell_quote (buf ? buf : "");
+  g_free (buf);
+
+  return arg;
+#endif
+}
+
+static gchar *
+link_arg (GtkWidget *w)
+{
+  return g_shell_quote (gtk_link_button_get_uri (GTK_LINK_BUTTON (w)));
+}
+
+static gchar *
+color_arg (GtkWidget *w)
+{
+  gchar *buf, *arg;
+#if !GTK_CHECK_VERSION(3,4,0)
+  GdkColor c;
+  GtkColorButton *cb = GTK_COLOR_BUTTON (w);
+  gtk_color_button_get_color (cb, &c);
+  buf = get_color (&c, gtk_color_button_get_alpha (cb));
+#else
+  GdkRGBA c;
+  GtkColorChooser *cb = GTK_COLOR_CHOOSER (w);
+  gtk_color_chooser_get_rgba (cb, &c);
+  buf = get_color (&c);
+#endif
+  arg = g_shell_quote (buf ? buf : "");
+  g_free (buf);
+
+  return arg;
+}
+
+static gchar *
+text_arg (GtkWidget *w)
+{
+  GtkTextBuffer *tb;
+  GtkTextIter b, e;
+  gchar *txt, *buf, *arg;
+
+  tb = gtk_text_view_get_buffer (GTK_TEXT_VIEW (w));
+  gtk_text_buffer_get_bounds (tb, &b, &e);
+  txt = gtk_text_buffer_get_text (tb, &b, &e, FALSE);
+
+  /* escape special chars */
+  buf = escape_str (txt);
+  g_free (txt);
+
+  /* escape quotes */
+  txt = escape_char (buf, '"');
+  g_free (buf);
+
+  arg = g_shell_quote (txt ? txt : "");
+  g_free (txt);
+
+  return arg;
+}
+
+/* get function for fetching field value as a command argument */
+static FieldArgFunc
+get_arg_func (YadFieldType type)
+{
+  switch (type)
+    {
+    case YAD_FIELD_SIMPLE:
+    case YAD_FIELD_HIDDEN:
+    case YAD_FIELD_READ_ONLY:
+    case YAD_FIELD_COMPLETE:
+    case YAD_FIELD_FILE_SAVE:
+    case YAD_FIELD_DIR_CREATE:
+    case YAD_FIELD_MFILE:
+    case YAD_FIELD_MDIR:
+    case YAD_FIELD_DATE:
+      return entry_arg;
+    case YAD_FIELD_NUM:
+      return num_arg;
+#if !GTK_CHECK_VERSION(3,0,0)
+    case YAD_FIELD_SWITCH:
+#endif
+    case YAD_FIELD_CHECK:
+      return check_arg;
+    case YAD_FIELD_COMBO:
+    case YAD_FIELD_COMBO_ENTRY:
+      return combo_arg;
+#if GTK_CHECK_VERSION(3,0,0)
+    case YAD_FIELD_SWITCH:
+      return switch_arg;
+#endif
+    case YAD_FIELD_SCALE:
+      return scale_arg;
+    case YAD_FIELD_FILE:
+    case YAD_FIELD_DIR:
+      return file_arg;
+    case YAD_FIELD_FONT:
+      return font_arg;
+    case YAD_FIELD_LINK:
+      return link_arg;
+    case YAD_FIELD_COLOR:
+      return color_arg;
+    case YAD_FIELD_TEXT:
+      return text_arg;
+    default:
+      return NULL;
+    }
+}
+
+static void
+free_token (ActionToken *t)
+{
+  g_free (t->text);
+  g_free (t);
+}
+
+static void
+add_text_token (GPtrArray *tpl, GString *text)
+{
+  ActionToken *t;
+
+  if (text->len == 0)
+    return;
+
+  t = g_new0 (ActionToken, 1);
+  t->text = g_strndup (text->str, text->len);
+  g_ptr_array_add (tpl, t);
+
+  g_string_truncate (text, 0);
+}
+
+static void
+add_field_token (GPtrArray *tpl, GString *text, guint num)
+{
+  ActionToken *t;
+  YadField *fld = g_slist_nth_data (options.form_data.fields, num);
+  FieldArgFunc get_arg = get_arg_func (fld->type);
+
+  /* fields without value expand to nothing */
+  if (!get_arg)
+    return;
+
+  add_text_token (tpl, text);
+
+  t = g_new0 (ActionToken, 1);
+  t->get_arg = get_arg;
+  t->w = GTK_WIDGET (g_slist_nth_data (fields, num));
+  g_ptr_array_add (tpl, t);
+}
+
+/* parse command into the list of text spans and %N field references.
+ * must be called after all form fields are created */
+static GPtrArray *
+compile_action (gchar *command)
+{
+  GPtrArray *tpl;
+  GString *text;
   guint i = 0;
   gchar *cmd;
   gboolean needs_free;
 
+  tpl = g_ptr_array_new_with_free_func ((GDestroyNotify) free_token);
+  text = g_string_new (NULL);
+
   needs_free = preprocess_atid (command, "\\\\%1$s|%1$s\\b(?!:)", &cmd);
-  xcmd = g_string_new ("");
   while (cmd[i])
     {
       if (cmd[i] == '%')
@@ -145,142 +403,65 @@ expand_action (gchar *command)
           i++;
           if (g_ascii_isdigit (cmd[i]))
             {
-              YadField *fld;
-              gchar *buf, *arg;
               guint num, j = i;
 
               /* get field num */
               while (g_ascii_isdigit (cmd[j]))
                 j++;
-              buf = g_strndup (cmd + i, j - i);
-              num = g_ascii_strtoll (buf, NULL, 10);
-              g_free (buf);
+              num = g_ascii_strtoull (cmd + i, NULL, 10);
+              /* wrong field number is left as a plain text */
               if (num > 0 && num <= n_fields)
-                num--;
-              else
-                continue;
-
-              /* get field value */
-              arg = NULL;
-              fld = g_slist_nth_data (options.form_data.fields, num);
-              switch (fld->type)
                 {
-                case YAD_FIELD_SIMPLE:
-                case YAD_FIELD_HIDDEN:
-                case YAD_FIELD_READ_ONLY:
-                case YAD_FIELD_COMPLETE:
-                case YAD_FIELD_FILE_SAVE:
-                case YAD_FIELD_DIR_CREATE:
-                case YAD_FIELD_MFILE:
-                case YAD_FIELD_MDIR:
-                case YAD_FIELD_DATE:
-                  buf = escape_char ((gchar *) gtk_entry_get_text (GTK_ENTRY (g_slist_nth_data (fields, num))), '"');
-                  arg = g_shell_quote (buf ? buf : "");
-                  g_free (buf);
-                  break;
-                case YAD_FIELD_NUM:
-                  {
-                    guint prec = gtk_spin_button_get_digits (GTK_SPIN_BUTTON (g_slist_nth_data (fields, num)));
-                    arg = g_strdup_printf ("%.*f", prec, gtk_spin_button_get_value (GTK_SPIN_BUTTON (g_slist_nth_data (fields, num))));
-                    break;
-                  }
-#if !GTK_CHECK_VERSION(3,0,0)
-                case YAD_FIELD_SWITCH:
-#endif
-                case YAD_FIELD_CHECK:
-                  arg = g_strdup (print_bool_val (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (g_slist_nth_data (fields, num)))));
-                  break;
-                case YAD_FIELD_COMBO:
-                case YAD_FIELD_COMBO_ENTRY:
-                  buf = gtk_combo_box_text_get_active_text (GTK_COMBO_BOX_TEXT (g_slist_nth_data (fields, num)));
-                  arg = g_shell_quote (buf ? buf : "");
-                  g_free (buf);
-                  break;
-#if GTK_CHECK_VERSION(3,0,0)
-                case YAD_FIELD_SWITCH:
-                  arg = g_strdup (print_bool_val (gtk_switch_get_state (GTK_SWITCH (g_slist_nth_data (fields, num)))));
-                  break;
-#endif
-                case YAD_FIELD_SCALE:
-                  arg = g_strdup_printf ("%d", (gint) gtk_range_get_value (GTK_RANGE (g_slist_nth_data (fields, num))));
-                  break;
-                case YAD_FIELD_FILE:
-                case YAD_FIELD_DIR:
-                  arg = g_shell_quote (gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (g_slist_nth_data (fields, num))));
-                  break;
-                case YAD_FIELD_FONT:
-#if !GTK_CHECK_VERSION(3,2,0)
-                  arg = g_shell_quote (gtk_font_button_get_font_name (GTK_FONT_BUTTON (g_slist_nth_data (fields, num))));
-#else
-                  arg = g_shell_quote (gtk_font_chooser_get_font (GTK_FONT_CHOOSER (g_slist_nth_data (fields, num))));
-#endif
-                  break;
-                case YAD_FIELD_LINK:
-                  arg = g_shell_quote (gtk_link_button_get_uri (GTK_LINK_BUTTON (g_slist_nth_data (fields, num))));
-                  break;
-                case YAD_FIELD_COLOR:
-                  {
-#if !GTK_CHECK_VERSION(3,4,0)
-                    GdkColor c;
-                    GtkColorButton *cb = GTK_COLOR_BUTTON (g_slist_nth_data (fields, num));
-                    gtk_color_button_get_color (cb, &c);
-                    buf = get_color (&c, gtk_color_button_get_alpha (cb));
-#else
-                    GdkRGBA c;
-                    GtkColorChooser *cb = GTK_COLOR_CHOOSER (g_slist_nth_data (fields, num));
-                    gtk_color_chooser_get_rgba (cb, &c);
-                    buf = get_color (&c);
-#endif
-                    arg = g_shell_quote (buf ? buf : "");
-                    g_free (buf);
-                    break;
-                  }
-                case YAD_FIELD_TEXT:
-                  {
-                    GtkTextBuffer *tb;
-                    GtkTextIter b, e;
-                    gchar *txt;
-
-                    tb = gtk_text_view_get_buffer (GTK_TEXT_VIEW (g_slist_nth_data (fields, num)));
-                    gtk_text_buffer_get_bounds (tb, &b, &e);
-                    txt = gtk_text_buffer_get_text (tb, &b, &e, FALSE);
-
-                    /* escape special chars */
-                    buf = escape_str (txt);
-                    g_free (txt);
-
-                    /* escape quotes */
-                    txt = escape_char (buf, '"');
-                    g_free (buf);
-
-                    arg = g_shell_quote (txt ? txt : "");
-                    g_free (txt);
-                  }
-                default: ;
-                }
-              if (arg)
-                {
-                  g_string_append (xcmd, arg);
-                  g_free (arg);
+                  add_field_token (tpl, text, num - 1);
+                  i = j;
                 }
-              i = j;
             }
-          else
+          else if (cmd[i])
             {
-              g_string_append_c (xcmd, cmd[i]);
+              g_string_append_c (text, cmd[i]);
               i++;
             }
         }
       else
         {
-          g_string_append_c (xcmd, cmd[i]);
+          g_string_append_c (text, cmd[i]);
           i++;
         }
     }
-  g_string_append_c (xcmd, '\0');
+  add_text_token (tpl, text);
+
+  g_string_free (text, TRUE);
   if (needs_free)
     g_free (cmd);
 
+  return tpl;
+}
+
+/* expand compiled action with current fields values */
+static GString *
+expand_action (GPtrArray *tpl)
+{
+  GString *xcmd;
+  guint i;
+
+  xcmd = g_string_new (NULL);
+  for (i = 0; i < tpl->len; i++)
+    {
+      ActionToken *t = g_ptr_array_index (tpl, i);
+
+      if (t->text)
+        g_string_append (xcmd, t->text);
+      else
+        {
+          gchar *arg = t->get_arg (t->w);
+          if (arg)
+            {
+              g_string_append (xcmd, arg);
+              g_free (arg);
+            }
+        }
+    }
+
   return xcmd;
 }
 
@@ -291,6 +472,11 @@ set_field_value (guint num, gchar *value)
   gchar **s;
   YadField *fld = g_slist_nth_data (options.form_data.fields, num);
 
+  set_serial++;
+
+  g_free (values[num]);
+  values[num] = g_strdup (value);
+
   w = GTK_WIDGET (g_slist_nth_data (fields, num));
   if (g_ascii_strcasecmp (value, "@disabled@") == 0)
     {
@@ -368,32 +554,25 @@ set_field_value (guint num, gchar *value)
       {
         GtkEntryCompletion *c;
         GtkTreeModel *m;
-        GtkTreeIter it;
-        gint i = 0, def = -1;
+        gint def;
 
         c = gtk_entry_get_completion (GTK_ENTRY (w));
-        m = gtk_entry_completion_get_model (GTK_ENTRY_COMPLETION (c));
-        gtk_list_store_clear (GTK_LIST_STORE (m));
+        m = get_items_model (value, &def);
+        gtk_entry_completion_set_model (c, m);
 
-        s = g_strsplit (value, options.common_data.item_separator, -1);
-        while (s[i])
+        if (def >= 0)
           {
-            gtk_list_store_append (GTK_LIST_STORE (m), &it);
-            if (s[i][0] == '^')
-              {
-                gtk_list_store_set (GTK_LIST_STORE (m), &it, 0, g_strcompress (s[i] + 1), -1);
-                def = i;
-              }
-            else
-              gtk_list_store_set (GTK_LIST_STORE (m), &it, 0, g_strcompress (s[i]), -1);
+            GtkTreeIter it;
+            gchar *buf = NULL;
 
-            i++;
+            if (gtk_tree_model_iter_nth_child (m, &it, NULL, def))
+              gtk_tree_model_get (m, &it, 0, &buf, -1);
+            gtk_entry_set_text (GTK_ENTRY (w), buf ? buf : "");
+            g_free (buf);
           }
-        if (def >= 0)
-          gtk_entry_set_text (GTK_ENTRY (w), s[def] + 1);
         else
           gtk_entry_set_text (GTK_ENTRY (w), "");
-        g_strfreev (s);
+        g_object_unref (m);
         break;
       }
 
@@ -401,30 +580,13 @@ set_field_value (guint num, gchar *value)
     case YAD_FIELD_COMBO_ENTRY:
       {
         GtkTreeModel *m;
-        gint i = 0, def = 0;
+        gint def;
 
-        /* cleanup previous values */
-        m = gtk_combo_box_get_model (GTK_COMBO_BOX (w));
-        gtk_list_store_clear (GTK_LIST_STORE (m));
-
-        s = g_strsplit (value, options.common_data.item_separator, -1);
-        while (s[i])
-          {
-            gchar *buf;
-
-            if (s[i][0] == '^')
-              {
-                buf = g_strcompress (s[i] + 1);
-                def = i;
-              }
-            else
-              buf = g_strcompress (s[i]);
-            gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (w), buf);
-            g_free (buf);
-            i++;
-          }
-        gtk_combo_box_set_active (GTK_COMBO_BOX (w), def);
-        g_strfreev (s);
+        /* items models are shared between fields with the same values */
+        m = get_items_model (value, &def);
+        gtk_combo_box_set_model (GTK_COMBO_BOX (w), m);
+        gtk_combo_box_set_active (GTK_COMBO_BOX (w), def >= 0 ? def : 0);
+        g_object_unref (m);
         break;
       }
 
@@ -463,6 +625,8 @@ set_field_value (guint num, gchar *value)
     case YAD_FIELD_BUTTON:
     case YAD_FIELD_FULL_BUTTON:
       g_object_set_data_full (G_OBJECT (w), "cmd", g_strdup (value), g_free);
+      g_object_set_data_full (G_OBJECT (w), "tpl", compile_action (value[0] == '@' ? value + 1 : value),
+                              (GDestroyNotify) g_ptr_array_unref);
       break;
 
     case YAD_FIELD_LINK:
@@ -523,25 +687,22 @@ static void
 button_clicked_cb (GtkButton * b, gpointer d)
 {
   gchar *action = (gchar *) g_object_get_data (G_OBJECT (b), "cmd");
+  GPtrArray *tpl = (GPtrArray *) g_object_get_data (G_OBJECT (b), "tpl");
 
   if (action && action[0])
     {
-      GString *cmd;
+      GString *cmd = expand_action (tpl);
       if (action[0] == '@')
         {
           gchar *data = NULL;
           gint exit = 1;
-          cmd = expand_action (action + 1);
           exit = run_command_sync (cmd->str, &data, GTK_WIDGET (b));
           if (exit == 0)
             parse_cmd_output (data);
           g_free (data);
         }
       else
-        {
-          cmd = expand_action (action);
-          run_command_async (cmd->str);
-        }
+        run_command_async (cmd->str);
       g_string_free (cmd, TRUE);
     }
 
@@ -550,31 +711,100 @@ button_clicked_cb (GtkButton * b, gpointer d)
     gtk_widget_grab_focus (GTK_WIDGET (g_slist_nth_data (fields, options.form_data.focus_field - 1)));
 }
 
+static void run_changed_action (guint fn);
+
 static void
-field_changed_cb (GtkWidget *w, guint fn)
+changed_action_done (gint ret, gchar *out, gpointer data)
 {
-  gchar *data = NULL;
-  gint exit = 1;
+  guint fn = GPOINTER_TO_UINT (data);
+  ChangedAction *ca = &changed[fn];
 
-  if (disable_changed)
-    return;
+  ca->running = FALSE;
+
+  /* field was changed again while command runs, result is outdated */
+  if (ca->pending)
+    {
+      g_free (ca->run_cmd);
+      ca->run_cmd = NULL;
+      ca->pending = FALSE;
+      run_changed_action (fn);
+      return;
+    }
+  if (ca->timer)
+    {
+      g_free (ca->run_cmd);
+      ca->run_cmd = NULL;
+      return;
+    }
 
-  if (options.form_data.changed_action)
+  g_free (ca->last_cmd);
+  ca->last_cmd = NULL;
+  if (ret == 0)
     {
-      gchar *str;
-      GString *cmd;
+      parse_cmd_output (out);
+      ca->last_cmd = ca->run_cmd;
+      ca->last_serial = set_serial;
+    }
+  else
+    g_free (ca->run_cmd);
+  ca->run_cmd = NULL;
+}
 
-      str = g_strdup_printf ("%s %d %%%d", options.form_data.changed_action, fn + 1, fn + 1);
-      cmd = expand_action (str);
-      g_free (str);
+static void
+run_changed_action (guint fn)
+{
+  GString *cmd;
+  ChangedAction *ca = &changed[fn];
+
+  /* only one command per field at a time */
+  if (ca->running)
+    {
+      ca->pending = TRUE;
+      return;
+    }
 
-      exit = run_command_sync (cmd->str, &data, w);
-      if (exit == 0)
-        parse_cmd_output (data);
-      g_free (data);
+  /* compile action for this field on first change */
+  if (!ca->tpl)
+    {
+      gchar *str = g_strdup_printf ("%s %d %%%d", options.form_data.changed_action, fn + 1, fn + 1);
+      ca->tpl = compile_action (str);
+      g_free (str);
+    }
+  cmd = expand_action (ca->tpl);
 
+  /* skip if nothing changed since last applied run */
+  if (ca->last_serial == set_serial && g_strcmp0 (cmd->str, ca->last_cmd) == 0)
+    {
       g_string_free (cmd, TRUE);
+      return;
     }
+  ca->run_cmd = g_string_free (cmd, FALSE);
+
+  ca->running = TRUE;
+  run_command_cb (ca->run_cmd, changed_action_done, GUINT_TO_POINTER (fn));
+}
+
+static gboolean
+changed_timeout_cb (gpointer data)
+{
+  guint fn = GPOINTER_TO_UINT (data);
+
+  changed[fn].timer = 0;
+  run_changed_action (fn);
+
+  return FALSE;
+}
+
+static void
+field_changed_cb (GtkWidget *w, guint fn)
+{
+  if (disable_changed || !options.form_data.changed_action)
+    return;
+
+  /* restart timer, so only the last change in a burst runs the action */
+  if (changed[fn].timer)
+    g_source_remove (changed[fn].timer);
+  changed[fn].timer = g_timeout_add (CHANGED_ACTION_DELAY, changed_timeout_cb, GUINT_TO_POINTER (fn));
 }
 
 static void
@@ -824,6 +1054,100 @@ select_icon_cb (GtkEntry *e, GtkEntryIconPosition pos, GdkEventButton *ev, gpoin
       exit = run_command_sync (cmd, &out, GTK_WIDGET (e));
 }
 */
+/* get current value of field widget. NULL for fields without value */
+static gchar *
+get_field_arg (guint fn)
+{
+  YadField *fld = g_slist_nth_data (options.form_data.fields, fn);
+  FieldArgFunc func = get_arg_func (fld->type);
+
+  return func ? func (GTK_WIDGET (g_slist_nth_data (fields, fn))) : NULL;
+}
+
+/* apply pending keyed updates, skip fields which still show the same values */
+static void
+commit_batch (void)
+{
+  GSList *b;
+
+  batch_ids = g_slist_reverse (batch_ids);
+  for (b = batch_ids; b; b = b->next)
+    {
+      guint fn = GPOINTER_TO_UINT (b->data);
+      gchar *cur = get_field_arg (fn);
+
+      /* field may be edited by user since last update */
+      if (g_strcmp0 (batch[fn], values[fn]) != 0 || g_strcmp0 (cur, shown[fn]) != 0)
+        {
+          set_field_value (fn, batch[fn]);
+          g_free (shown[fn]);
+          shown[fn] = get_field_arg (fn);
+        }
+      g_free (cur);
+      g_free (batch[fn]);
+      batch[fn] = NULL;
+    }
+  g_slist_free (batch_ids);
+  batch_ids = NULL;
+}
+
+static void
+add_to_batch (guint fn, gchar *value)
+{
+  if (batch[fn])
+    g_free (batch[fn]);
+  else
+    batch_ids = g_slist_prepend (batch_ids, GUINT_TO_POINTER (fn));
+  batch[fn] = g_strdup (value);
+}
+
+/* parse line of keyed input: N=VALUE or @ID=VALUE. empty line commits the batch */
+static void
+parse_keyed_line (gchar *line)
+{
+  gchar *val;
+  gint fn = -1;
+
+  if (!line[0])
+    {
+      commit_batch ();
+      return;
+    }
+
+  if (line[0] == '\014')
+    {
+      guint i;
+      /* clear all fields */
+      for (i = 0; i < n_fields; i++)
+        add_to_batch (i, "");
+      return;
+    }
+
+  val = strchr (line, '=');
+  if (!val)
+    {
+      if (options.debug)
+        g_printerr (_("yad: wrong keyed data line: %s\n"), line);
+      return;
+    }
+  *val++ = '\0';
+
+  if (line[0] == '@')
+    fn = GPOINTER_TO_INT (g_hash_table_lookup (atids, line)) - 1;
+  else if (g_ascii_isdigit (line[0]))
+    {
+      gchar *end;
+      guint64 num = g_ascii_strtoull (line, &end, 10);
+      if (*end == '\0' && num > 0 && num <= n_fields)
+        fn = num - 1;
+    }
+
+  if (fn >= 0)
+    add_to_batch (fn, val);
+  else if (options.debug)
+    g_printerr (_("yad: unknown field %s\n"), line);
+}
+
 static gboolean
 handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
 {
@@ -840,7 +1164,7 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
         {
           gint status;
 
-          if (cnt == n_fields)
+          if (!options.form_data.keyed_read && cnt == n_fields)
             {
               if (options.form_data.cycle_read)
                 cnt = 0;
@@ -870,7 +1194,9 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
             }
 
           strip_new_line (string->str);
-          if (string->str[0])
+          if (options.form_data.keyed_read)
+            parse_keyed_line (string->str);
+          else if (string->str[0])
             {
               if (string->str[0] == '\014')
                 {
@@ -883,7 +1209,8 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
               else
                 set_field_value (cnt, string->str);
             }
-          cnt++;
+          if (!options.form_data.keyed_read)
+            cnt++;
         }
       while (g_io_channel_get_buffer_condition (ch) == G_IO_IN);
       g_string_free (string, TRUE);
@@ -896,6 +1223,8 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
 
  shutdown:
   g_io_channel_shutdown (ch, TRUE, NULL);
+  if (options.form_data.keyed_read)
+    commit_batch ();
   disable_changed = FALSE;
   return FALSE;
 }
@@ -913,6 +1242,8 @@ form_create_widget (GtkWidget * dlg)
       guint i, col, row, rows;
 
       n_fields = g_slist_length (options.form_data.fields);
+      changed = g_new0 (ChangedAction, n_fields);
+      values = g_new0 (gchar *, n_fields);
 
       row = col = 0;
       rows = n_fields / options.form_data.columns;
@@ -1027,8 +1358,7 @@ form_create_widget (GtkWidget * dlg)
                   gtk_entry_completion_set_model (c, GTK_TREE_MODEL (m));
                   gtk_entry_completion_set_text_column (c, 0);
 
-                  if (options.common_data.complete != YAD_COMPLETE_SIMPLE)
-                    gtk_entry_completion_set_match_func (c, check_complete, NULL, NULL);
+                  gtk_entry_completion_set_match_func (c, check_complete, NULL, NULL);
 
                   g_object_unref (m);
                   g_object_unref (c);
@@ -1553,7 +1883,24 @@ form_create_widget (GtkWidget * dlg)
         }
       else
         {
-          GIOChannel *channel = g_io_channel_unix_new (0);
+          GIOChannel *channel;
+
+          if (options.form_data.keyed_read)
+            {
+              GSList *f;
+
+              batch = g_new0 (gchar *, n_fields);
+              shown = g_new0 (gchar *, n_fields);
+              atids = g_hash_table_new (g_str_hash, g_str_equal);
+              for (f = options.form_data.fields, i = 1; f; f = f->next, i++)
+                {
+                  YadField *fld = (YadField *) f->data;
+                  if (fld->atid)
+                    g_hash_table_insert (atids, fld->atid, GUINT_TO_POINTER (i));
+                }
+            }
+
+          channel = g_io_channel_unix_new (0);
           g_io_channel_set_encoding (channel, NULL, NULL);
           g_io_channel_set_flags (channel, G_IO_FLAG_NONBLOCK, NULL);
           g_io_add_watch (channel, G_IO_IN | G_IO_HUP, handle_stdin, NULL);
@@ -24,20 +24,31 @@
 
 #ifdef USE_WEBKIT2
 #include <webkit2/webkit2.h>
+#include <gio/gunixinputstream.h>
 #else
 #include <webkit/webkit.h>
 #endif
 
 static WebKitWebView *view;
 
-static GString *inbuf;
-
 #ifdef USE_WEBKIT2
+/* scheme for streaming data from stdin into the view */
+#define STDIN_SCHEME "yad-stdin"
+
 static gboolean is_loaded = FALSE;
+static gboolean stdin_used = FALSE;
 #else
+static GString *inbuf;
+
 static gboolean is_link = FALSE;
 #endif
 
+/* listen mode state */
+static GString *msg = NULL;
+static gchar *pending_doc = NULL;
+static GHashTable *pending_patches = NULL;
+static guint flush_idle = 0;
+
 #ifndef PATH_MAX
 #define PATH_MAX 4096
 #endif
@@ -321,19 +332,40 @@ icon_cb (GObject *obj, GParamSpec *spec, GtkWindow *dlg)
     }
 }
 
+#ifdef USE_WEBKIT2
+/* webkit reads stdin asynchronously and renders document as data arrives */
+static void
+stdin_scheme_cb (WebKitURISchemeRequest *req, gpointer d)
+{
+  GInputStream *stream;
+  GError *err;
+
+  /* stdin can be read only once */
+  if (stdin_used)
+    {
+      err = g_error_new (G_IO_ERROR, G_IO_ERROR_CLOSED, _("Standard input is already read"));
+      webkit_uri_scheme_request_finish_error (req, err);
+      g_error_free (err);
+      return;
+    }
+  stdin_used = TRUE;
+
+  stream = g_unix_input_stream_new (0, FALSE);
+  webkit_uri_scheme_request_finish (req, stream, -1, options.html_data.mime ? options.html_data.mime : "text/html");
+  g_object_unref (stream);
+}
+#else
 static gboolean
 handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer d)
 {
   gchar *buf;
-#ifdef USE_WEBKIT2
-  GBytes *data;
-#endif
   GError *err = NULL;
 
   switch (g_io_channel_read_line (ch, &buf, NULL, NULL, &err))
     {
     case G_IO_STATUS_NORMAL:
       g_string_append (inbuf, buf);
+      g_free (buf);
       return TRUE;
 
     case G_IO_STATUS_ERROR:
@@ -342,14 +374,10 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer d)
       return FALSE;
 
     case G_IO_STATUS_EOF:
-#ifdef USE_WEBKIT2
-      data = g_bytes_new (inbuf->str, inbuf->len);
-      /*g_string_free (inbuf, TRUE); */ /* FIXME: IS THAT NEEDED ??? (and where) */
-      webkit_web_view_load_bytes (view, data, options.html_data.mime, options.html_data.encoding, NULL);
-      g_bytes_unref (data);
-#else
       webkit_web_view_load_string (view, inbuf->str, options.html_data.mime, options.html_data.encoding, NULL);
-#endif
+      /* webkit keeps its own copy of data */
+      g_string_free (inbuf, TRUE);
+      inbuf = NULL;
       return FALSE;
 
     case G_IO_STATUS_AGAIN:
@@ -358,6 +386,219 @@ handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer d)
 
   return FALSE;
 }
+#endif
+
+/* make javascript string literal */
+static gchar *
+escape_js (const gchar *str)
+{
+  GString *res = g_string_sized_new (strlen (str) + 2);
+  const gchar *p;
+
+  g_string_append_c (res, '"');
+  for (p = str; *p; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (res, "\\\"");
+          break;
+        case '\\':
+          g_string_append (res, "\\\\");
+          break;
+        case '\n':
+          g_string_append (res, "\\n");
+          break;
+        case '\r':
+          g_string_append (res, "\\r");
+          break;
+        default:
+          /* line and paragraph separators are not allowed in js strings */
+          if (g_str_has_prefix (p, "\xe2\x80\xa8") || g_str_has_prefix (p, "\xe2\x80\xa9"))
+            {
+              g_string_append (res, p[2] == '\xa8' ? "\\u2028" : "\\u2029");
+              p += 2;
+            }
+          else
+            g_string_append_c (res, *p);
+        }
+    }
+  g_string_append_c (res, '"');
+
+  return g_string_free (res, FALSE);
+}
+
+static void
+run_script (const gchar *script)
+{
+#ifdef USE_WEBKIT2
+#if WEBKIT_CHECK_VERSION(2,40,0)
+  webkit_web_view_evaluate_javascript (view, script, -1, NULL, NULL, NULL, NULL, NULL);
+#else
+  webkit_web_view_run_javascript (view, script, NULL, NULL, NULL);
+#endif
+#else
+  webkit_web_view_execute_script (view, script);
+#endif
+}
+
+static gboolean
+is_loading ()
+{
+#ifdef USE_WEBKIT2
+  return webkit_web_view_is_loading (view);
+#else
+  WebKitLoadStatus st = webkit_web_view_get_load_status (view);
+  return (st != WEBKIT_LOAD_FINISHED && st != WEBKIT_LOAD_FAILED);
+#endif
+}
+
+/* apply collected updates. only the last update of document or element is applied */
+static gboolean
+flush_updates (gpointer d)
+{
+  GHashTableIter it;
+  gpointer id, html;
+
+  flush_idle = 0;
+
+  if (pending_doc)
+    {
+#ifdef USE_WEBKIT2
+      /* allow navigation for new content */
+      is_loaded = FALSE;
+      webkit_web_view_load_html (view, pending_doc, NULL);
+#else
+      webkit_web_view_load_string (view, pending_doc, options.html_data.mime, options.html_data.encoding, NULL);
+#endif
+      g_free (pending_doc);
+      pending_doc = NULL;
+    }
+
+  /* patches will be applied when document is loaded */
+  if (is_loading ())
+    return FALSE;
+
+  g_hash_table_iter_init (&it, pending_patches);
+  while (g_hash_table_iter_next (&it, &id, &html))
+    {
+      gchar *eid, *ehtml, *script;
+
+      eid = escape_js (id);
+      ehtml = escape_js (html);
+      script = g_strdup_printf ("(function(){var e=document.getElementById(%s);if(e)e.innerHTML=%s;})();", eid, ehtml);
+      run_script (script);
+      g_free (script);
+      g_free (ehtml);
+      g_free (eid);
+    }
+  g_hash_table_remove_all (pending_patches);
+
+  return FALSE;
+}
+
+#ifdef USE_WEBKIT2
+static void
+listen_loaded_cb (WebKitWebView *v, WebKitLoadEvent ev, gpointer d)
+{
+  if (ev == WEBKIT_LOAD_FINISHED && g_hash_table_size (pending_patches) > 0)
+    flush_updates (NULL);
+}
+#else
+static void
+listen_loaded_cb (WebKitWebView *v, WebKitWebFrame *f, gpointer d)
+{
+  if (g_hash_table_size (pending_patches) > 0)
+    flush_updates (NULL);
+}
+#endif
+
+/* message started with #ID line replaces content of element with id ID. other messages replaces the whole document */
+static void
+parse_message ()
+{
+  if (msg->len == 0)
+    return;
+
+  if (msg->str[0] == '#')
+    {
+      gchar *nl = strchr (msg->str, '\n');
+      gchar *id;
+
+      id = g_strndup (msg->str + 1, nl ? nl - msg->str - 1 : msg->len - 1);
+      g_strstrip (id);
+      if (id[0])
+        g_hash_table_replace (pending_patches, id, g_strdup (nl ? nl + 1 : ""));
+      else
+        g_free (id);
+    }
+  else
+    {
+      g_free (pending_doc);
+      pending_doc = g_strdup (msg->str);
+      /* new document drops all previous patches */
+      g_hash_table_remove_all (pending_patches);
+    }
+
+  g_string_truncate (msg, 0);
+
+  /* updates are applied when all available input is read */
+  if (!flush_idle)
+    flush_idle = g_idle_add (flush_updates, NULL);
+}
+
+static gboolean
+handle_listen (GIOChannel * channel, GIOCondition condition, gpointer data)
+{
+  if (condition & (G_IO_IN | G_IO_HUP))
+    {
+      GString *string;
+      GError *err = NULL;
+      gint status;
+
+      string = g_string_new (NULL);
+
+      do
+        {
+          status = g_io_channel_read_line_string (channel, string, NULL, &err);
+          while (gtk_events_pending ())
+            gtk_main_iteration ();
+        }
+      while (status == G_IO_STATUS_AGAIN);
+
+      if (status != G_IO_STATUS_NORMAL)
+        {
+          if (err)
+            {
+              g_printerr ("yad_html_handle_stdin(): %s\n", err->message);
+              g_error_free (err);
+              err = NULL;
+            }
+          /* apply the rest of data */
+          g_string_append (msg, string->str);
+          parse_message ();
+          g_string_free (string, TRUE);
+          /* stop handling */
+          g_io_channel_shutdown (channel, TRUE, NULL);
+          return FALSE;
+        }
+
+      if (string->str[0] == '\014')
+        {
+          /* form feed finishes the message. the rest of line starts a new one */
+          parse_message ();
+          g_string_append (msg, string->str + 1);
+          if (msg->len == 1 && msg->str[0] == '\n')
+            g_string_truncate (msg, 0);
+        }
+      else
+        g_string_append (msg, string->str);
+
+      g_string_free (string, TRUE);
+    }
+
+  return TRUE;
+}
 
 GtkWidget *
 html_create_widget (GtkWidget * dlg)
@@ -439,8 +680,32 @@ html_create_widget (GtkWidget * dlg)
 
   if (options.html_data.uri)
     load_uri (options.html_data.uri);
+  else if (!options.html_data.browser && options.common_data.listen)
+    {
+      GIOChannel *ch;
+
+      msg = g_string_new (NULL);
+      pending_patches = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+#ifdef USE_WEBKIT2
+      g_signal_connect (view, "load-changed", G_CALLBACK (listen_loaded_cb), NULL);
+#else
+      g_signal_connect (view, "load-finished", G_CALLBACK (listen_loaded_cb), NULL);
+#endif
+
+      ch = g_io_channel_unix_new (0);
+      g_io_channel_set_encoding (ch, NULL, NULL);
+      g_io_channel_set_flags (ch, G_IO_FLAG_NONBLOCK, NULL);
+      g_io_add_watch (ch, G_IO_IN | G_IO_HUP, handle_listen, NULL);
+    }
   else if (!options.html_data.browser)
     {
+#ifdef USE_WEBKIT2
+      webkit_web_context_register_uri_scheme (webkit_web_view_get_context (view), STDIN_SCHEME,
+                                              stdin_scheme_cb, NULL, NULL);
+      if (options.html_data.encoding)
+        webkit_settings_set_default_charset (settings, options.html_data.encoding);
+      webkit_web_view_load_uri (view, STDIN_SCHEME ":///");
+#else
       GIOChannel *ch;
 
       inbuf = g_string_new (NULL);
@@ -448,6 +713,7 @@ html_create_widget (GtkWidget * dlg)
       g_io_channel_set_encoding (ch, NULL, NULL);
       g_io_channel_set_flags (ch, G_IO_FLAG_NONBLOCK, NULL);
       g_io_add_watch (ch, G_IO_IN | G_IO_HUP, handle_stdin, NULL);
+#endif
     }
   else if (options.extra_data)
     load_uri (options.extra_data[0]);
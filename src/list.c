@@ -24,27 +24,114 @@
 
 static GtkWidget *list_view;
 
+/* model with list data. list view shows it through filter if filter bar is used */
+static GtkTreeModel *list_store = NULL;
+static GtkTreeModel *filter_model = NULL;
+
+/* index of tree rows by id. values are persistent tree store iters */
 static GHashTable *row_hash = NULL;
+static gint id_col = -1;
+static gulong changed_hndl = 0;
+
+/* index of rows by key column value */
+static GHashTable *key_hash = NULL;
+static gint key_col = -1;
+
+/* filter bar. searchable text of rows is cached in hidden column */
+static gint text_col = -1;
+static gchar *filter_key = NULL;
+static gboolean filtering = FALSE;
+static guint filter_timeout = 0;
+static gchar **row_buf = NULL;
+
+/* snapshot mode. rows of last applied snapshot by key */
+typedef struct {
+  gchar *key;                   /* key of removed row */
+  gchar **vals;                 /* values of new or changed row */
+  guint8 *changed;              /* changed cells. NULL for new row */
+  gchar *prev;                  /* key of previous row in snapshot for new row */
+} SnapOp;
+
+typedef struct {
+  GHashTable *old;
+  GPtrArray *rows;
+  GHashTable *snap;
+  GArray *ops;
+} SnapJob;
+
+static GHashTable *snap_cur = NULL;
+static GPtrArray *snap_rows = NULL;
+static GPtrArray *snap_pending = NULL;
+static gboolean snap_busy = FALSE;
+
+/* rows waiting for adding in limited list. only the last limit rows are kept */
+static gchar ***ring = NULL;
+static guint ring_start = 0;
+static guint ring_len = 0;
+
+/* deferred updates of view */
+static gboolean update_pending = FALSE;
+static gboolean scroll_pending = FALSE;
+/* ids of parents got new children */
+static GHashTable *expand_set = NULL;
+
+static void schedule_update (void);
+
+/* lazy loading of tree nodes */
+enum {
+  LAZY_WAIT = 1,
+  LAZY_LOADING,
+  LAZY_DONE
+};
+
+typedef struct {
+  gchar *id;                    /* id of expanded node */
+  gboolean cleared;             /* placeholder is removed */
+  gchar *row_id;
+  gchar *par_id;
+  gchar **row;
+  gint col;                     /* number of read values. -1 if id line is expected */
+} LazyLoad;
+
+static GHashTable *lazy_hash = NULL;
+static gint lazy_col = -1;              /* hidden column which marks placeholder rows */
+
+/* paged data source */
+static GtkAdjustment *page_adj = NULL;
+static GHashTable *page_cache = NULL;    /* prefetched pages output */
+static GHashTable *page_loading = NULL;
+static guint first_page = 0;            /* number of the first page in list */
+static guint n_pages = 0;               /* number of pages in list */
+static gint last_page = -1;             /* number of the last page if known */
+static gint page_col = -1;              /* hidden column with page number of row */
 
 static gint fore_col, back_col, font_col;
 static guint n_cols = 0;
 
 static gulong select_hndl = 0;
 
+/* copy of iter for indexes. g_memdup() is deprecated */
+static inline GtkTreeIter *
+copy_iter (GtkTreeIter *it)
+{
+  GtkTreeIter *res = g_new (GtkTreeIter, 1);
+
+  *res = *it;
+  return res;
+}
+
 static inline void
 yad_list_add_row (GtkTreeStore *m, GtkTreeIter *it, gchar *row_id, gchar *par_id)
 {
-  GtkTreePath *row_path;
   GtkTreeIter *parent = NULL;
 
   if (par_id && par_id[0])
     {
-      GtkTreePath *par_path = g_hash_table_lookup (row_hash, par_id);
-      if (par_path)
+      parent = g_hash_table_lookup (row_hash, par_id);
+      if (parent && expand_set)
         {
-          GtkTreeIter pit;
-          if (gtk_tree_model_get_iter (GTK_TREE_MODEL (m), &pit, par_path))
-            parent = &pit;
+          g_hash_table_insert (expand_set, g_strdup (par_id), GINT_TO_POINTER (1));
+          schedule_update ();
         }
     }
 
@@ -53,11 +140,114 @@ yad_list_add_row (GtkTreeStore *m, GtkTreeIter *it, gchar *row_id, gchar *par_id
   else
     gtk_tree_store_append (m, it, parent);
 
-  row_path = gtk_tree_model_get_path (GTK_TREE_MODEL (m), it);
   if (row_id && row_id[0])
-    g_hash_table_insert (row_hash, row_id, row_path);
+    {
+      gtk_tree_store_set (m, it, id_col, row_id, -1);
+      g_hash_table_replace (row_hash, g_strdup (row_id), copy_iter (it));
+    }
+
+  /* scroll once per frame */
   if (options.common_data.tail)
-    gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (list_view), row_path, NULL, FALSE, 1.0, 1.0);
+    {
+      scroll_pending = TRUE;
+      schedule_update ();
+    }
+}
+
+static void
+drop_index (GHashTable *hash, gint col, GtkTreeModel *m, GtkTreeIter *it)
+{
+  GtkTreeIter child;
+  gchar *id;
+
+  if (gtk_tree_model_iter_children (m, &child, it))
+    {
+      do
+        drop_index (hash, col, m, &child);
+      while (gtk_tree_model_iter_next (m, &child));
+    }
+
+  gtk_tree_model_get (m, it, col, &id, -1);
+  if (id)
+    {
+      GtkTreeIter *ri = g_hash_table_lookup (hash, id);
+      if (ri && ri->user_data == it->user_data)
+        g_hash_table_remove (hash, id);
+      g_free (id);
+    }
+}
+
+/* drop index entries of row and its children before removing it */
+static void
+unindex_row (GtkTreeModel *m, GtkTreeIter *it)
+{
+  if (row_hash)
+    drop_index (row_hash, id_col, m, it);
+  if (key_hash)
+    drop_index (key_hash, key_col, m, it);
+}
+
+static void
+remove_row (GtkTreeModel *m, GtkTreeIter *it)
+{
+  unindex_row (m, it);
+  gtk_tree_store_remove (GTK_TREE_STORE (m), it);
+}
+
+/* rows moved by drag and drop are copied before removing. keep index pointed to the new copy */
+static void
+row_changed_cb (GtkTreeModel *m, GtkTreePath *path, GtkTreeIter *it, gpointer data)
+{
+  gchar *id;
+
+  if (row_hash)
+    {
+      gtk_tree_model_get (m, it, id_col, &id, -1);
+      if (id)
+        g_hash_table_replace (row_hash, id, copy_iter (it));
+    }
+  if (key_hash)
+    {
+      gtk_tree_model_get (m, it, key_col, &id, -1);
+      if (id)
+        g_hash_table_replace (key_hash, id, copy_iter (it));
+    }
+}
+
+static inline void
+block_index_updates (gboolean block)
+{
+  if (!changed_hndl)
+    return;
+
+  if (block)
+    g_signal_handler_block (G_OBJECT (list_store), changed_hndl);
+  else
+    g_signal_handler_unblock (G_OBJECT (list_store), changed_hndl);
+}
+
+/* convert iter of list view to store iter */
+static inline void
+to_store_iter (GtkTreeIter *it)
+{
+  GtkTreeIter vit;
+
+  if (filter_model)
+    {
+      vit = *it;
+      gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (filter_model), it, &vit);
+    }
+}
+
+/* get store iter of list view row */
+static gboolean
+view_get_iter (GtkTreeIter *it, GtkTreePath *path)
+{
+  if (!gtk_tree_model_get_iter (gtk_tree_view_get_model (GTK_TREE_VIEW (list_view)), it, path))
+    return FALSE;
+  to_store_iter (it);
+
+  return TRUE;
 }
 
 static gboolean
@@ -88,6 +278,26 @@ list_activate_cb (GtkWidget *widget, GdkEventKey *event, gpointer data)
   return FALSE;
 }
 
+static void
+print_list (void)
+{
+  GtkWidget *top = gtk_widget_get_toplevel (list_view);
+
+  print_tree_view (GTK_TREE_VIEW (list_view), gtk_widget_is_toplevel (top) ? GTK_WINDOW (top) : NULL);
+}
+
+static gboolean
+list_key_cb (GtkWidget *widget, GdkEventKey *event, gpointer data)
+{
+  if ((event->state & GDK_CONTROL_MASK) && (event->keyval == GDK_KEY_P || event->keyval == GDK_KEY_p))
+    {
+      print_list ();
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 /* custom tooltip signal handler for no-markup mode */
 static gboolean
 tooltip_cb (GtkWidget *w, gint x, gint y, gboolean mode, GtkTooltip *tip, gpointer data)
@@ -122,10 +332,10 @@ toggled_cb (GtkCellRendererToggle *cell, gchar *path_str, gpointer data)
   gboolean fixed;
   GtkTreeIter iter;
   GtkTreePath *path = gtk_tree_path_new_from_string (path_str);
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
 
   column = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (cell), "column"));
-  gtk_tree_model_get_iter (model, &iter, path);
+  view_get_iter (&iter, path);
   gtk_tree_model_get (model, &iter, column, &fixed, -1);
 
   fixed ^= 1;
@@ -149,13 +359,13 @@ rtoggled_cb (GtkCellRendererToggle *cell, gchar *path_str, gpointer data)
   gint column;
   GtkTreeIter iter;
   GtkTreePath *path = gtk_tree_path_new_from_string (path_str);
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
 
   column = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (cell), "column"));
 
   gtk_tree_model_foreach (model, runtoggle, GINT_TO_POINTER (column));
 
-  gtk_tree_model_get_iter (model, &iter, path);
+  view_get_iter (&iter, path);
   gtk_tree_store_set (GTK_TREE_STORE (model), &iter, column, TRUE, -1);
 
   gtk_tree_path_free (path);
@@ -167,11 +377,11 @@ cell_edited_cb (GtkCellRendererText *cell, const gchar *path_string, const gchar
   gint column;
   GtkTreeIter iter;
   GtkTreePath *path = gtk_tree_path_new_from_string (path_string);
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
   YadColumn *col;
 
   column = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (cell), "column"));
-  gtk_tree_model_get_iter (model, &iter, path);
+  view_get_iter (&iter, path);
   col = (YadColumn *) g_slist_nth_data (options.list_data.columns, column);
 
   if (col->type == YAD_COLUMN_NUM)
@@ -184,36 +394,83 @@ cell_edited_cb (GtkCellRendererText *cell, const gchar *path_string, const gchar
   gtk_tree_path_free (path);
 }
 
-static gboolean
-regex_search (GtkTreeModel *model, gint col, const gchar *key, GtkTreeIter *iter, gpointer data)
+/* compiled pattern of regex search and cache of searched strings. one per view */
+typedef struct {
+  gchar *key;
+  GRegex *pattern;
+  GHashTable *cache;            /* store row node -> cell text */
+  guint deleted;                /* rows deleted since cache cleaning */
+  GtkTreeModel *model;
+  gulong hndl[3];
+} RegexSearch;
+
+static void
+free_regex_search (RegexSearch *rs)
 {
-  static GRegex *pattern = NULL;
-  static guint pos = 0;
-  gchar *str;
+  gint i;
+
+  for (i = 0; i < 3; i++)
+    g_signal_handler_disconnect (G_OBJECT (rs->model), rs->hndl[i]);
+  g_object_unref (rs->model);
+  g_free (rs->key);
+  if (rs->pattern)
+    g_regex_unref (rs->pattern);
+  g_hash_table_destroy (rs->cache);
+  g_free (rs);
+}
 
-  if (key[pos])
+/* drop cached text of changed or new row. new row may get the node of removed one */
+static void
+regex_row_changed (GtkTreeModel *m, GtkTreePath *path, GtkTreeIter *it, RegexSearch *rs)
+{
+  /* updates of filter text cache don't change cells */
+  if (filtering)
+    return;
+  g_hash_table_remove (rs->cache, it->user_data);
+}
+
+/* nodes of removed rows are unknown here. clean cache when it has too many of them */
+static void
+regex_row_deleted (GtkTreeModel *m, GtkTreePath *path, RegexSearch *rs)
+{
+  rs->deleted++;
+  if (rs->deleted > g_hash_table_size (rs->cache) / 2)
     {
-      if (pattern)
-        g_regex_unref (pattern);
-      pattern = g_regex_new (key, G_REGEX_CASELESS | G_REGEX_EXTENDED | G_REGEX_OPTIMIZE, G_REGEX_MATCH_NOTEMPTY, NULL);
-      pos = strlen (key);
+      g_hash_table_remove_all (rs->cache);
+      rs->deleted = 0;
     }
+}
 
-  if (pattern)
-    {
-      gboolean ret;
+static gboolean
+regex_search (GtkTreeModel *model, gint col, const gchar *key, GtkTreeIter *iter, RegexSearch *rs)
+{
+  GtkTreeIter it = *iter;
+  gchar *str;
 
-      gtk_tree_model_get (model, iter, col, &str, -1);
+  /* compile pattern only when search key is changed */
+  if (g_strcmp0 (rs->key, key) != 0)
+    {
+      g_free (rs->key);
+      rs->key = g_strdup (key);
+      if (rs->pattern)
+        g_regex_unref (rs->pattern);
+      rs->pattern = g_regex_new (key, G_REGEX_CASELESS | G_REGEX_EXTENDED | G_REGEX_OPTIMIZE, G_REGEX_MATCH_NOTEMPTY, NULL);
+    }
 
-      ret = g_regex_match (pattern, str, G_REGEX_MATCH_NOTEMPTY, NULL);
-      /* if get it, clear key end position */
-      if (!ret)
-        pos = 0;
+  /* incomplete pattern matches nothing */
+  if (!rs->pattern)
+    return TRUE;
 
-      return !ret;
+  /* tree store iters are persistent, so row node is a stable key until row changes.
+     cell text is copied only on the first search after change */
+  to_store_iter (&it);
+  if (!g_hash_table_lookup_extended (rs->cache, it.user_data, NULL, (gpointer *) &str))
+    {
+      gtk_tree_model_get (list_store, &it, col, &str, -1);
+      g_hash_table_insert (rs->cache, it.user_data, str);
     }
-  else
-    return TRUE;
+
+  return str ? !g_regex_match (rs->pattern, str, G_REGEX_MATCH_NOTEMPTY, NULL) : TRUE;
 }
 
 static GtkTreeModel *
@@ -223,7 +480,7 @@ create_model ()
   GType *ctypes;
   gint i;
 
-  ctypes = g_new0 (GType, n_cols);
+  ctypes = g_new0 (GType, n_cols + 3);
 
   if (options.list_data.checkbox)
     {
@@ -275,7 +532,35 @@ create_model ()
         }
     }
 
-  store = gtk_tree_store_newv (n_cols, ctypes);
+  /* hidden columns with row id or key, searchable text and page number or placeholder mark */
+  i = n_cols;
+  if (options.list_data.tree_mode)
+    {
+      id_col = i++;
+      ctypes[id_col] = G_TYPE_STRING;
+    }
+  else if (key_hash)
+    {
+      key_col = i++;
+      ctypes[key_col] = G_TYPE_STRING;
+    }
+  if (options.list_data.filter_bar)
+    {
+      text_col = i++;
+      ctypes[text_col] = G_TYPE_STRING;
+    }
+  if (options.list_data.page_cmd && !options.list_data.tree_mode)
+    {
+      page_col = i++;
+      ctypes[page_col] = G_TYPE_UINT;
+    }
+  else if (lazy_hash)
+    {
+      lazy_col = i++;
+      ctypes[lazy_col] = G_TYPE_BOOLEAN;
+    }
+  store = gtk_tree_store_newv (i, ctypes);
+  g_free (ctypes);
 
   return GTK_TREE_MODEL (store);
 }
@@ -335,237 +620,1860 @@ set_column_title (GtkTreeViewColumn *col, gchar *title)
     }
 
   gtk_widget_show (lbl);
-  gtk_tree_view_column_set_widget (col, lbl);
+
+  /* spinner is shown while column is sorting */
+  if (options.list_data.clickable)
+    {
+      GtkWidget *box, *spin;
+
+#if !GTK_CHECK_VERSION(3,0,0)
+      box = gtk_hbox_new (FALSE, 2);
+#else
+      box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 2);
+#endif
+      gtk_box_pack_start (GTK_BOX (box), lbl, TRUE, TRUE, 0);
+      spin = gtk_spinner_new ();
+      gtk_box_pack_start (GTK_BOX (box), spin, FALSE, FALSE, 0);
+      g_object_set_data (G_OBJECT (col), "spinner", spin);
+      gtk_widget_show (box);
+      gtk_tree_view_column_set_widget (col, box);
+    }
+  else
+    gtk_tree_view_column_set_widget (col, lbl);
+  g_strfreev (str);
+}
+
+/* background sorting */
+typedef struct {
+  gchar *key;                   /* collation key of text value */
+  gint64 ival;
+  gdouble dval;
+  guint pos;                    /* position before sorting */
+  GtkTreeIter iter;             /* persistent store iter of row */
+} SortKey;
+
+typedef struct {
+  GtkTreeIter parent;
+  gboolean root;
+  guint n;
+  SortKey *keys;
+} SortLevel;
+
+typedef struct {
+  GtkTreeViewColumn *column;
+  gint col;
+  GType type;
+  GtkSortType order;
+  guint stamp;
+  guint shape;
+  GPtrArray *levels;
+} SortJob;
+
+/* delay of resorting after changes. it grows while changes keep coming during sorting */
+#define RESORT_DELAY 500
+#define MAX_RESORT_DELAY 8000
+
+static guint sort_stamp = 0;    /* increased on each change of rows */
+static guint shape_stamp = 0;   /* increased on each row insertion or removal */
+static gboolean sort_busy = FALSE;
+static GtkTreeViewColumn *sort_column = NULL;
+static GtkSortType sort_order = GTK_SORT_ASCENDING;
+static guint resort_timeout = 0;
+static guint resort_delay = RESORT_DELAY;
+
+static void
+free_sort_job (SortJob *job)
+{
+  guint i, j;
+
+  for (i = 0; i < job->levels->len; i++)
+    {
+      SortLevel *lvl = g_ptr_array_index (job->levels, i);
+
+      for (j = 0; j < lvl->n; j++)
+        g_free (lvl->keys[j].key);
+      g_free (lvl->keys);
+      g_free (lvl);
+    }
+  g_ptr_array_free (job->levels, TRUE);
+  g_free (job);
 }
 
+/* read values of sorting column from tree level. runs in main thread */
 static void
-add_columns ()
+collect_level (GtkTreeModel *model, GtkTreeIter *parent, SortJob *job)
 {
-  gint i;
-  GtkCellRenderer *renderer;
-  GtkTreeViewColumn *column;
+  SortLevel *lvl;
+  GtkTreeIter iter;
+  guint i;
 
-  for (i = 0; i < n_cols; i++)
+  lvl = g_new0 (SortLevel, 1);
+  lvl->root = (parent == NULL);
+  if (parent)
+    lvl->parent = *parent;
+  lvl->n = gtk_tree_model_iter_n_children (model, parent);
+  if (lvl->n < 2)
     {
-      YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, i);
+      g_free (lvl);
+      lvl = NULL;
+    }
+  else
+    {
+      lvl->keys = g_new0 (SortKey, lvl->n);
+      g_ptr_array_add (job->levels, lvl);
+    }
 
-      if (i == options.list_data.hide_column - 1 || col->type == YAD_COLUMN_HIDDEN ||
-          i == fore_col || i == back_col || i == font_col)
-        continue;
+  if (!gtk_tree_model_iter_children (model, &iter, parent))
+    return;
 
-      switch (col->type)
+  i = 0;
+  do
+    {
+      if (lvl)
         {
-        case YAD_COLUMN_CHECK:
-        case YAD_COLUMN_RADIO:
-          renderer = gtk_cell_renderer_toggle_new ();
-          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "active", i, NULL);
-          set_column_title (column, col->name);
-          if (back_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
-          if (col->type == YAD_COLUMN_RADIO)
-            {
-              gtk_cell_renderer_toggle_set_radio (GTK_CELL_RENDERER_TOGGLE (renderer), TRUE);
-              g_signal_connect (renderer, "toggled", G_CALLBACK (rtoggled_cb), NULL);
-            }
-          else
-            g_signal_connect (renderer, "toggled", G_CALLBACK (toggled_cb), NULL);
-          break;
-        case YAD_COLUMN_IMAGE:
-          renderer = gtk_cell_renderer_pixbuf_new ();
-          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "pixbuf", i, NULL);
-          set_column_title (column, col->name);
-          if (back_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
-          break;
-        case YAD_COLUMN_NUM:
-        case YAD_COLUMN_SIZE:
-        case YAD_COLUMN_FLOAT:
-          renderer = gtk_cell_renderer_text_new ();
-          if (col->editable)
-            {
-              g_object_set (G_OBJECT (renderer), "editable", TRUE, NULL);
-              g_signal_connect (renderer, "edited", G_CALLBACK (cell_edited_cb), NULL);
-            }
-          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "text", i, NULL);
-          set_column_title (column, col->name);
-          if (fore_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "foreground", fore_col);
-          if (back_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
-          if (font_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "font", font_col);
-          gtk_tree_view_column_set_sort_column_id (column, i);
-          gtk_tree_view_column_set_resizable (column, TRUE);
-          if (col->type == YAD_COLUMN_FLOAT)
-            gtk_tree_view_column_set_cell_data_func (column, renderer, float_col_format, GINT_TO_POINTER (i), NULL);
-          else if (col->type == YAD_COLUMN_SIZE)
-            gtk_tree_view_column_set_cell_data_func (column, renderer, size_col_format, GINT_TO_POINTER (i), NULL);
-          break;
-        case YAD_COLUMN_BAR:
-          renderer = gtk_cell_renderer_progress_new ();
-          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "value", i, NULL);
-          set_column_title (column, col->name);
-          if (back_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
-          gtk_tree_view_column_set_sort_column_id (column, i);
-          gtk_tree_view_column_set_resizable (column, TRUE);
-          break;
-        default:
-          renderer = gtk_cell_renderer_text_new ();
-          if (col->editable)
-            {
-              g_object_set (G_OBJECT (renderer), "editable", TRUE, NULL);
-              g_signal_connect (renderer, "edited", G_CALLBACK (cell_edited_cb), NULL);
-            }
-          if (options.data.no_markup)
-            column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "text", i, NULL);
+          SortKey *k = &lvl->keys[i];
+
+          k->pos = i;
+          k->iter = iter;
+          if (job->type == G_TYPE_INT64)
+            gtk_tree_model_get (model, &iter, job->col, &k->ival, -1);
+          else if (job->type == G_TYPE_DOUBLE)
+            gtk_tree_model_get (model, &iter, job->col, &k->dval, -1);
           else
-            column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "markup", i, NULL);
-          set_column_title (column, col->name);
-          if (col->ellipsize)
-            g_object_set (G_OBJECT (renderer), "ellipsize", options.list_data.ellipsize, NULL);
-          if (col->wrap)
+            gtk_tree_model_get (model, &iter, job->col, &k->key, -1);
+        }
+      if (gtk_tree_model_iter_has_child (model, &iter))
+        collect_level (model, &iter, job);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (model, &iter));
+}
+
+static gint
+sort_key_cmp (SortKey *a, SortKey *b, SortJob *job)
+{
+  gint ret;
+
+  if (job->type == G_TYPE_INT64)
+    ret = (a->ival > b->ival) - (a->ival < b->ival);
+  else if (job->type == G_TYPE_DOUBLE)
+    ret = (a->dval > b->dval) - (a->dval < b->dval);
+  else
+    ret = strcmp (a->key, b->key);
+
+  if (job->order == GTK_SORT_DESCENDING)
+    ret = -ret;
+
+  /* keep equal rows in the same order */
+  return ret ? ret : (gint) a->pos - (gint) b->pos;
+}
+
+static gboolean sort_done (SortJob *job);
+
+static gpointer
+sort_thread (SortJob *job)
+{
+  guint i, j;
+
+  for (i = 0; i < job->levels->len; i++)
+    {
+      SortLevel *lvl = g_ptr_array_index (job->levels, i);
+
+      /* replace values with collation keys */
+      if (job->type == G_TYPE_STRING)
+        {
+          for (j = 0; j < lvl->n; j++)
             {
-              g_object_set (G_OBJECT (renderer), "wrap-width", options.list_data.wrap_width, NULL);
-              g_object_set (G_OBJECT (renderer), "wrap-mode", PANGO_WRAP_WORD_CHAR, NULL);
+              gchar *str = lvl->keys[j].key;
+
+              lvl->keys[j].key = g_utf8_collate_key (str ? str : "", -1);
+              g_free (str);
             }
-          if (fore_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "foreground", fore_col);
-          if (back_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
-          if (font_col != -1)
-            gtk_tree_view_column_add_attribute (column, renderer, "font", font_col);
-          gtk_tree_view_column_set_sort_column_id (column, i);
-          gtk_tree_view_column_set_resizable (column, TRUE);
+        }
+
+      g_qsort_with_data (lvl->keys, lvl->n, sizeof (SortKey), (GCompareDataFunc) sort_key_cmp, job);
+    }
+
+  g_idle_add ((GSourceFunc) sort_done, job);
+
+  return NULL;
+}
+
+static void
+start_sort (GtkTreeViewColumn *column, GtkSortType order)
+{
+  GtkTreeModel *model = list_store;
+  GtkWidget *spin;
+  SortJob *job;
+
+  sort_busy = TRUE;
+
+  job = g_new0 (SortJob, 1);
+  job->column = column;
+  job->col = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (column), "sort-column"));
+  job->type = gtk_tree_model_get_column_type (model, job->col);
+  job->order = order;
+  job->stamp = sort_stamp;
+  job->shape = shape_stamp;
+  job->levels = g_ptr_array_new ();
+
+  collect_level (model, NULL, job);
+
+  if ((spin = g_object_get_data (G_OBJECT (column), "spinner")) != NULL)
+    {
+      gtk_widget_show (spin);
+      gtk_spinner_start (GTK_SPINNER (spin));
+    }
+
+  g_thread_unref (g_thread_new ("sort", (GThreadFunc) sort_thread, job));
+}
+
+static gboolean resort_cb (gpointer data);
+
+static void
+schedule_resort ()
+{
+  if (resort_timeout)
+    return;
+
+  resort_timeout = g_timeout_add (resort_delay, resort_cb, NULL);
+}
+
+/* get iters of all rows with children */
+static void
+collect_parents (GtkTreeModel *model, GtkTreeIter *parent, GHashTable *nodes)
+{
+  GtkTreeIter iter;
+
+  if (!gtk_tree_model_iter_children (model, &iter, parent))
+    return;
+
+  do
+    {
+      if (gtk_tree_model_iter_has_child (model, &iter))
+        {
+          g_hash_table_insert (nodes, iter.user_data, copy_iter (&iter));
+          collect_parents (model, &iter, nodes);
+        }
+    }
+  while (gtk_tree_model_iter_next (model, &iter));
+}
+
+/* apply sorted order to rows which still exist. new rows are placed after them */
+static void
+reorder_level (GtkTreeModel *model, GtkTreeIter *parent, SortLevel *lvl)
+{
+  GHashTable *pos;
+  GtkTreeIter iter;
+  gint *order;
+  gint n, i, k;
+  guint j;
+
+  n = gtk_tree_model_iter_n_children (model, parent);
+  if (n < 2)
+    return;
+
+  /* store node -> position + 1 */
+  pos = g_hash_table_new (g_direct_hash, g_direct_equal);
+  gtk_tree_model_iter_children (model, &iter, parent);
+  i = 0;
+  do
+    {
+      g_hash_table_insert (pos, iter.user_data, GINT_TO_POINTER (++i));
+    }
+  while (gtk_tree_model_iter_next (model, &iter));
+
+  order = g_new (gint, n);
+  k = 0;
+  for (j = 0; j < lvl->n; j++)
+    {
+      gint p = GPOINTER_TO_INT (g_hash_table_lookup (pos, lvl->keys[j].iter.user_data));
+
+      if (p)
+        {
+          order[k++] = p - 1;
+          g_hash_table_remove (pos, lvl->keys[j].iter.user_data);
+        }
+    }
+  if (k < n)
+    {
+      gtk_tree_model_iter_children (model, &iter, parent);
+      i = 0;
+      do
+        {
+          if (g_hash_table_contains (pos, iter.user_data))
+            order[k++] = i;
+          i++;
+        }
+      while (gtk_tree_model_iter_next (model, &iter));
+    }
+
+  gtk_tree_store_reorder (GTK_TREE_STORE (model), parent, order);
+  g_free (order);
+  g_hash_table_destroy (pos);
+}
+
+static gboolean
+sort_done (SortJob *job)
+{
+  GtkTreeModel *model = list_store;
+  GtkWidget *spin;
+  GList *cols, *c;
+  gint *order;
+  guint i, j;
+
+  sort_busy = FALSE;
+  sort_column = job->column;
+  sort_order = job->order;
+
+  if (job->shape != shape_stamp)
+    {
+      GHashTable *nodes = NULL;
+
+      /* rows were added or removed while sorting. sort the rows which are left
+         and place new ones after them. removed rows are recognized by their
+         store nodes, as store iters persist */
+      for (i = 0; i < job->levels->len; i++)
+        {
+          SortLevel *lvl = g_ptr_array_index (job->levels, i);
+          GtkTreeIter *parent = NULL;
+
+          if (!lvl->root)
+            {
+              if (!nodes)
+                {
+                  nodes = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+                  collect_parents (model, NULL, nodes);
+                }
+              if ((parent = g_hash_table_lookup (nodes, lvl->parent.user_data)) == NULL)
+                continue;
+            }
+          reorder_level (model, parent, lvl);
+        }
+      if (nodes)
+        g_hash_table_destroy (nodes);
+
+      /* new rows need sorting too */
+      resort_delay = MIN (resort_delay * 2, MAX_RESORT_DELAY);
+      schedule_resort ();
+    }
+  else
+    {
+      for (i = 0; i < job->levels->len; i++)
+        {
+          SortLevel *lvl = g_ptr_array_index (job->levels, i);
+
+          order = g_new (gint, lvl->n);
+          for (j = 0; j < lvl->n; j++)
+            order[j] = lvl->keys[j].pos;
+          gtk_tree_store_reorder (GTK_TREE_STORE (model), lvl->root ? NULL : &lvl->parent, order);
+          g_free (order);
+        }
+
+      /* values were changed while sorting. fix order later */
+      if (job->stamp != sort_stamp)
+        schedule_resort ();
+      else
+        resort_delay = RESORT_DELAY;
+    }
+
+  if ((spin = g_object_get_data (G_OBJECT (job->column), "spinner")) != NULL)
+    {
+      gtk_spinner_stop (GTK_SPINNER (spin));
+      gtk_widget_hide (spin);
+    }
+
+  /* update sort indicators */
+  cols = gtk_tree_view_get_columns (GTK_TREE_VIEW (list_view));
+  for (c = cols; c; c = c->next)
+    gtk_tree_view_column_set_sort_indicator (GTK_TREE_VIEW_COLUMN (c->data), c->data == job->column);
+  g_list_free (cols);
+  gtk_tree_view_column_set_sort_order (job->column, job->order);
+
+  free_sort_job (job);
+
+  return FALSE;
+}
+
+static void
+sort_clicked_cb (GtkTreeViewColumn *column, gpointer data)
+{
+  if (sort_busy)
+    return;
+
+  if (column == sort_column && sort_order == GTK_SORT_ASCENDING)
+    start_sort (column, GTK_SORT_DESCENDING);
+  else
+    start_sort (column, GTK_SORT_ASCENDING);
+}
+
+static gboolean
+resort_cb (gpointer data)
+{
+  if (sort_busy)
+    return TRUE;
+
+  resort_timeout = 0;
+  if (sort_column)
+    start_sort (sort_column, sort_order);
+
+  return FALSE;
+}
+
+/* keep sorted list in order after data changes */
+static void
+rows_changed_cb (GtkTreeModel *m, GtkTreePath *path, gpointer data)
+{
+  sort_stamp++;
+  shape_stamp++;
+
+  if (sort_column)
+    schedule_resort ();
+}
+
+static void
+row_inserted_cb (GtkTreeModel *m, GtkTreePath *path, GtkTreeIter *it, gpointer data)
+{
+  rows_changed_cb (m, path, data);
+}
+
+static void
+sort_value_changed_cb (GtkTreeModel *m, GtkTreePath *path, GtkTreeIter *it, gpointer data)
+{
+  /* filter updates don't change values */
+  if (filtering)
+    return;
+
+  sort_stamp++;
+
+  if (sort_column)
+    schedule_resort ();
+}
+
+static void
+set_sort_column (GtkTreeViewColumn *column, gint num)
+{
+  g_object_set_data (G_OBJECT (column), "sort-column", GINT_TO_POINTER (num));
+  g_signal_connect (G_OBJECT (column), "clicked", G_CALLBACK (sort_clicked_cb), NULL);
+}
+
+/* get folded text of all text columns of row */
+static gchar *
+get_search_text (GtkTreeModel *model, GtkTreeIter *iter)
+{
+  GString *str = g_string_new (NULL);
+  gchar *res;
+  gint i;
+
+  for (i = 0; i < n_cols; i++)
+    {
+      YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, i);
+      gchar *val = NULL;
+
+      if (col->type != YAD_COLUMN_TEXT || i == options.list_data.hide_column - 1)
+        continue;
+
+      gtk_tree_model_get (model, iter, i, &val, -1);
+      if (!val)
+        continue;
+
+      /* search in text without markup */
+      if (!options.data.no_markup)
+        {
+          gchar *plain = NULL;
+
+          if (pango_parse_markup (val, -1, 0, NULL, &plain, NULL, NULL))
+            {
+              g_free (val);
+              val = plain;
+            }
+        }
+
+      g_string_append (str, val);
+      g_string_append_c (str, '\n');
+      g_free (val);
+    }
+
+  res = g_utf8_casefold (str->str, str->len);
+  g_string_free (str, TRUE);
+
+  return res;
+}
+
+/* check if row or one of its children matches filter */
+static gboolean
+row_matches (GtkTreeModel *model, GtkTreeIter *iter)
+{
+  GtkTreeIter child;
+  gchar *text;
+  gboolean res;
+
+  gtk_tree_model_get (model, iter, text_col, &text, -1);
+  if (!text)
+    text = get_search_text (model, iter);
+  res = (strstr (text, filter_key) != NULL);
+  g_free (text);
+
+  if (!res && gtk_tree_model_iter_children (model, &child, iter))
+    {
+      do
+        {
+          if ((res = row_matches (model, &child)) != FALSE)
+            break;
+        }
+      while (gtk_tree_model_iter_next (model, &child));
+    }
+
+  return res;
+}
+
+static gboolean
+row_visible (GtkTreeModel *model, GtkTreeIter *iter, gpointer data)
+{
+  if (!filter_key || !filter_key[0])
+    return TRUE;
+
+  return row_matches (model, iter);
+}
+
+/* update cached text of changed row. runs before the filter handler */
+static void
+text_changed_cb (GtkTreeModel *m, GtkTreePath *path, GtkTreeIter *it, gpointer data)
+{
+  gchar *text;
+
+  if (filtering)
+    return;
+
+  gtk_tree_model_get (m, it, text_col, &text, -1);
+  if (text)
+    {
+      gchar *new_text = NULL;
+
+      /* rows without cache are handled on the next filter change */
+      if (filter_key && filter_key[0])
+        new_text = get_search_text (m, it);
+
+      filtering = TRUE;
+      gtk_tree_store_set (GTK_TREE_STORE (m), it, text_col, new_text, -1);
+      filtering = FALSE;
+      g_free (new_text);
+      g_free (text);
+    }
+}
+
+/* number of rows got text cache in one idle call */
+#define FILL_CHUNK 1000
+
+static guint fill_idle = 0;
+static GtkTreePath *fill_path = NULL;   /* next row for text cache */
+
+/* get next row in depth-first order */
+static gboolean
+next_row (GtkTreeModel *model, GtkTreeIter *iter)
+{
+  GtkTreeIter it = *iter, parent;
+
+  if (gtk_tree_model_iter_children (model, iter, &it))
+    return TRUE;
+
+  while (TRUE)
+    {
+      *iter = it;
+      if (gtk_tree_model_iter_next (model, iter))
+        return TRUE;
+      if (!gtk_tree_model_iter_parent (model, &parent, &it))
+        return FALSE;
+      it = parent;
+    }
+}
+
+static void
+stop_fill_text ()
+{
+  if (fill_idle)
+    {
+      g_source_remove (fill_idle);
+      fill_idle = 0;
+    }
+  if (fill_path)
+    {
+      gtk_tree_path_free (fill_path);
+      fill_path = NULL;
+    }
+}
+
+/* fill text cache of rows which don't have it by chunks. rows without cache are checked anyway */
+static gboolean
+fill_text_idle (gpointer data)
+{
+  GtkTreeIter iter;
+  gboolean more = TRUE;
+  gint n;
+
+  if (!filter_key || !filter_key[0] || !gtk_tree_model_get_iter (list_store, &iter, fill_path))
+    {
+      fill_idle = 0;
+      stop_fill_text ();
+      return FALSE;
+    }
+
+  filtering = TRUE;
+  block_index_updates (TRUE);
+  for (n = 0; n < FILL_CHUNK && more; n++)
+    {
+      gchar *text;
+
+      gtk_tree_model_get (list_store, &iter, text_col, &text, -1);
+      if (!text)
+        {
+          text = get_search_text (list_store, &iter);
+          gtk_tree_store_set (GTK_TREE_STORE (list_store), &iter, text_col, text, -1);
+        }
+      g_free (text);
+
+      more = next_row (list_store, &iter);
+    }
+  block_index_updates (FALSE);
+  filtering = FALSE;
+
+  gtk_tree_path_free (fill_path);
+  fill_path = NULL;
+  if (!more)
+    {
+      fill_idle = 0;
+      return FALSE;
+    }
+  fill_path = gtk_tree_model_get_path (list_store, &iter);
+
+  return TRUE;
+}
+
+static void
+start_fill_text ()
+{
+  if (fill_idle)
+    return;
+  fill_path = gtk_tree_path_new_first ();
+  fill_idle = g_idle_add (fill_text_idle, NULL);
+}
+
+static gboolean
+collect_unmatched (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GArray *rows)
+{
+  GtkTreeIter it;
+
+  gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (model), &it, iter);
+  if (!row_matches (list_store, &it))
+    g_array_append_val (rows, it);
+
+  return FALSE;
+}
+
+static gboolean
+apply_filter (gpointer data)
+{
+  GtkEntry *entry = GTK_ENTRY (data);
+  gchar *key;
+
+  filter_timeout = 0;
+
+  key = g_utf8_casefold (gtk_entry_get_text (entry), -1);
+
+  filtering = TRUE;
+  block_index_updates (TRUE);
+
+  if (filter_key && filter_key[0] && key[0] && strstr (key, filter_key))
+    {
+      GArray *rows = g_array_new (FALSE, FALSE, sizeof (GtkTreeIter));
+      guint i;
+
+      /* refined query. only rows shown now needs to be checked */
+      g_free (filter_key);
+      filter_key = key;
+      gtk_tree_model_foreach (filter_model, (GtkTreeModelForeachFunc) collect_unmatched, rows);
+
+      /* make filter recheck unmatched rows. children goes first */
+      for (i = rows->len; i > 0; i--)
+        {
+          GtkTreeIter *it = &g_array_index (rows, GtkTreeIter, i - 1);
+          GtkTreePath *path = gtk_tree_model_get_path (list_store, it);
+
+          gtk_tree_model_row_changed (list_store, path, it);
+          gtk_tree_path_free (path);
+        }
+      g_array_free (rows, TRUE);
+    }
+  else
+    {
+      if (key[0])
+        start_fill_text ();
+      else
+        stop_fill_text ();
+      g_free (filter_key);
+      filter_key = key;
+      gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter_model));
+    }
+
+  block_index_updates (FALSE);
+  filtering = FALSE;
+
+  return FALSE;
+}
+
+static void
+filter_changed_cb (GtkEntry *entry, gpointer data)
+{
+  if (filter_timeout)
+    g_source_remove (filter_timeout);
+  filter_timeout = g_timeout_add (150, apply_filter, entry);
+}
+
+static void
+add_columns ()
+{
+  gint i;
+  GtkCellRenderer *renderer;
+  GtkTreeViewColumn *column;
+
+  for (i = 0; i < n_cols; i++)
+    {
+      YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, i);
+
+      if (i == options.list_data.hide_column - 1 || col->type == YAD_COLUMN_HIDDEN ||
+          i == fore_col || i == back_col || i == font_col)
+        continue;
+
+      switch (col->type)
+        {
+        case YAD_COLUMN_CHECK:
+        case YAD_COLUMN_RADIO:
+          renderer = gtk_cell_renderer_toggle_new ();
+          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "active", i, NULL);
+          set_column_title (column, col->name);
+          if (back_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
+          if (col->type == YAD_COLUMN_RADIO)
+            {
+              gtk_cell_renderer_toggle_set_radio (GTK_CELL_RENDERER_TOGGLE (renderer), TRUE);
+              g_signal_connect (renderer, "toggled", G_CALLBACK (rtoggled_cb), NULL);
+            }
+          else
+            g_signal_connect (renderer, "toggled", G_CALLBACK (toggled_cb), NULL);
+          break;
+        case YAD_COLUMN_IMAGE:
+          renderer = gtk_cell_renderer_pixbuf_new ();
+          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "pixbuf", i, NULL);
+          set_column_title (column, col->name);
+          if (back_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
+          break;
+        case YAD_COLUMN_NUM:
+        case YAD_COLUMN_SIZE:
+        case YAD_COLUMN_FLOAT:
+          renderer = gtk_cell_renderer_text_new ();
+          if (col->editable)
+            {
+              g_object_set (G_OBJECT (renderer), "editable", TRUE, NULL);
+              g_signal_connect (renderer, "edited", G_CALLBACK (cell_edited_cb), NULL);
+            }
+          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "text", i, NULL);
+          set_column_title (column, col->name);
+          if (fore_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "foreground", fore_col);
+          if (back_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
+          if (font_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "font", font_col);
+          set_sort_column (column, i);
+          gtk_tree_view_column_set_resizable (column, TRUE);
+          if (col->type == YAD_COLUMN_FLOAT)
+            gtk_tree_view_column_set_cell_data_func (column, renderer, float_col_format, GINT_TO_POINTER (i), NULL);
+          else if (col->type == YAD_COLUMN_SIZE)
+            gtk_tree_view_column_set_cell_data_func (column, renderer, size_col_format, GINT_TO_POINTER (i), NULL);
+          break;
+        case YAD_COLUMN_BAR:
+          renderer = gtk_cell_renderer_progress_new ();
+          column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "value", i, NULL);
+          set_column_title (column, col->name);
+          if (back_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
+          set_sort_column (column, i);
+          gtk_tree_view_column_set_resizable (column, TRUE);
+          break;
+        default:
+          renderer = gtk_cell_renderer_text_new ();
+          if (col->editable)
+            {
+              g_object_set (G_OBJECT (renderer), "editable", TRUE, NULL);
+              g_signal_connect (renderer, "edited", G_CALLBACK (cell_edited_cb), NULL);
+            }
+          if (options.data.no_markup)
+            column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "text", i, NULL);
+          else
+            column = gtk_tree_view_column_new_with_attributes (NULL, renderer, "markup", i, NULL);
+          set_column_title (column, col->name);
+          if (col->ellipsize)
+            g_object_set (G_OBJECT (renderer), "ellipsize", options.list_data.ellipsize, NULL);
+          if (col->wrap)
+            {
+              g_object_set (G_OBJECT (renderer), "wrap-width", options.list_data.wrap_width, NULL);
+              g_object_set (G_OBJECT (renderer), "wrap-mode", PANGO_WRAP_WORD_CHAR, NULL);
+            }
+          if (fore_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "foreground", fore_col);
+          if (back_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "cell-background", back_col);
+          if (font_col != -1)
+            gtk_tree_view_column_add_attribute (column, renderer, "font", font_col);
+          set_sort_column (column, i);
+          gtk_tree_view_column_set_resizable (column, TRUE);
+
+          if (col->type == YAD_COLUMN_TIP)
+            options.list_data.tooltip_column = i + 1;
+          break;
+        }
+      g_object_set_data (G_OBJECT (renderer), "column", GINT_TO_POINTER (i));
+      gtk_tree_view_append_column (GTK_TREE_VIEW (list_view), column);
+
+      gtk_tree_view_column_set_clickable (column, options.list_data.clickable);
+
+      if (col->type != YAD_COLUMN_CHECK && col->type != YAD_COLUMN_IMAGE)
+        {
+          if (i == options.list_data.expand_column - 1 || options.list_data.expand_column == 0)
+            gtk_tree_view_column_set_expand (column, TRUE);
+        }
+    }
+
+  if(options.list_data.search_column < 0)
+    options.list_data.search_column = 0;
+  if (options.list_data.search_column <= n_cols)
+    gtk_tree_view_set_search_column (GTK_TREE_VIEW (list_view), options.list_data.search_column - 1);
+}
+
+static void
+cell_set_data (GtkTreeIter *it, guint num, gchar *data)
+{
+  GtkTreeModel *model = list_store;
+  YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, num);
+
+  switch (col->type)
+    {
+    case YAD_COLUMN_CHECK:
+    case YAD_COLUMN_RADIO:
+        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, get_bool_val (data), -1);
+      break;
+    case YAD_COLUMN_NUM:
+    case YAD_COLUMN_SIZE:
+      gtk_tree_store_set (GTK_TREE_STORE (model), it, num, g_ascii_strtoll (data, NULL, 10), -1);
+      break;
+    case YAD_COLUMN_FLOAT:
+      gtk_tree_store_set (GTK_TREE_STORE (model), it, num, g_ascii_strtod (data, NULL), -1);
+      break;
+    case YAD_COLUMN_BAR:
+      {
+        gint64 val = g_ascii_strtoll (data, NULL, 10);
+        if (val < 0)
+          val = 0;
+        if (val > 100)
+          val = 100;
+        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, val, -1);
+        break;
+      }
+    case YAD_COLUMN_IMAGE:
+      {
+        gboolean b;
+        GdkPixbuf *pb;
+        GtkStockItem sit;
+        SETUNDEPR (b, gtk_stock_lookup, data, &sit);
+        if (b)
+          {
+            SETUNDEPR (pb, gtk_widget_render_icon, list_view, sit.stock_id, GTK_ICON_SIZE_MENU, "");
+          }
+        else
+          {
+            pb = get_pixbuf (data, YAD_SMALL_ICON, FALSE);
+          }
+        if (pb)
+          {
+            gtk_tree_store_set (GTK_TREE_STORE (model), it, num, pb, -1);
+            g_object_unref (pb);
+          }
+        break;
+      }
+    default:
+      if (data && *data)
+        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, data, -1);
+      break;
+    }
+}
+
+static gchar *
+cell_get_data (GtkTreeIter *it, guint num)
+{
+  gchar *data = NULL;
+  GtkTreeModel *model = list_store;
+  YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, num);
+
+  switch (col->type)
+    {
+    case YAD_COLUMN_CHECK:
+    case YAD_COLUMN_RADIO:
+      {
+        gboolean bval;
+        gtk_tree_model_get (model, it, num, &bval, -1);
+        data = g_strdup (print_bool_val (bval));
+        break;
+      }
+    case YAD_COLUMN_NUM:
+    case YAD_COLUMN_SIZE:
+    case YAD_COLUMN_BAR:
+      {
+        gint64 nval;
+        gtk_tree_model_get (model, it, num, &nval, -1);
+        data = g_strdup_printf ("%ld", (long) nval);
+        break;
+      }
+    case YAD_COLUMN_FLOAT:
+      {
+        gdouble nval;
+        gtk_tree_model_get (model, it, num, &nval, -1);
+        data = g_strdup_printf ("%lf", nval);
+        break;
+      }
+    case YAD_COLUMN_IMAGE:
+      {
+        data = g_strdup ("''");
+        break;
+      }
+    default:
+      {
+        gchar *cval;
+        gtk_tree_model_get (model, it, num, &cval, -1);
+        if (cval)
+          data = g_shell_quote (cval);
+        break;
+      }
+    }
+
+  return data;
+}
+
+/* like cell_set_data, but empty value clears text cell */
+static void
+update_cell (GtkTreeIter *it, guint num, gchar *data)
+{
+  YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, num);
+
+  if (!*data && (col->type == YAD_COLUMN_TEXT || col->type == YAD_COLUMN_TIP || col->type == YAD_COLUMN_HIDDEN ||
+                 col->type == YAD_COLUMN_ATTR_FORE || col->type == YAD_COLUMN_ATTR_BACK || col->type == YAD_COLUMN_ATTR_FONT))
+    {
+      GtkTreeModel *model = list_store;
+      gtk_tree_store_set (GTK_TREE_STORE (model), it, num, NULL, -1);
+    }
+  else
+    cell_set_data (it, num, data);
+}
+
+/* remove rows over the limit. the oldest rows go first */
+static void
+trim_rows (GtkTreeModel *model)
+{
+  GtkTreeIter victim;
+  gint n;
+
+  if (!options.list_data.limit)
+    return;
+
+  n = gtk_tree_model_iter_n_children (model, NULL) - (gint) options.list_data.limit;
+  if (n <= 0)
+    return;
+
+  if (options.list_data.add_on_top)
+    gtk_tree_model_iter_nth_child (model, &victim, NULL, options.list_data.limit);
+  else
+    gtk_tree_model_get_iter_first (model, &victim);
+
+  /* removing moves iter to the next row */
+  while (n-- > 0)
+    remove_row (model, &victim);
+}
+
+static void
+set_keyed_row (GtkTreeModel *model, GtkTreeIter *it, gchar **vals)
+{
+  gchar *key = vals[options.list_data.key_column - 1];
+  guint i;
+
+  for (i = 0; i < n_cols; i++)
+    cell_set_data (it, i, vals[i]);
+  gtk_tree_store_set (GTK_TREE_STORE (model), it, key_col, key, -1);
+  g_hash_table_replace (key_hash, g_strdup (key), copy_iter (it));
+}
+
+static void
+add_keyed_row (GtkTreeModel *model, gchar **vals)
+{
+  GtkTreeIter iter;
+
+  yad_list_add_row (GTK_TREE_STORE (model), &iter, NULL, NULL);
+  set_keyed_row (model, &iter, vals);
+}
+
+/* add new row of snapshot next to its predecessor, so snapshot order is kept */
+static void
+insert_snapshot_row (GtkTreeModel *model, gchar **vals, gchar *prev)
+{
+  GtkTreeIter iter, *sib = NULL;
+
+  if (prev)
+    sib = g_hash_table_lookup (key_hash, prev);
+
+  /* list with rows on top is shown in reverse order */
+  if (options.list_data.add_on_top)
+    gtk_tree_store_insert_before (GTK_TREE_STORE (model), &iter, NULL, sib);
+  else
+    gtk_tree_store_insert_after (GTK_TREE_STORE (model), &iter, NULL, sib);
+  set_keyed_row (model, &iter, vals);
+}
+
+/* update row with the same key or add a new one */
+static void
+upsert_row (GtkTreeModel *model, gchar **vals)
+{
+  GtkTreeIter *it;
+  gchar *key = vals[options.list_data.key_column - 1];
+  guint i;
+
+  if ((it = g_hash_table_lookup (key_hash, key)) != NULL)
+    {
+      for (i = 0; i < n_cols; i++)
+        update_cell (it, i, vals[i]);
+      return;
+    }
+
+  add_keyed_row (model, vals);
+  trim_rows (model);
+}
+
+/* run keyed command. commands are "del|KEY" and "set|KEY|COLUMN|VALUE" */
+static void
+run_key_command (GtkTreeModel *model, gchar *cmd)
+{
+  gchar **args = g_strsplit (cmd, options.common_data.separator, 4);
+  GtkTreeIter *it;
+
+  if (args[0] && args[1] && (it = g_hash_table_lookup (key_hash, args[1])) != NULL)
+    {
+      if (strcmp (args[0], "del") == 0)
+        {
+          /* index entry is freed while removing */
+          GtkTreeIter iter = *it;
+          remove_row (model, &iter);
+        }
+      else if (strcmp (args[0], "set") == 0 && args[2] && args[3])
+        {
+          guint num = atoi (args[2]);
+
+          if (num > 0 && num <= n_cols && num != options.list_data.key_column)
+            update_cell (it, num - 1, args[3]);
+        }
+    }
+  else if (options.debug && args[0])
+    g_printerr (_("WARNING: wrong list command '%s'\n"), cmd);
+
+  g_strfreev (args);
+}
+
+/* add empty child to node, so it can be expanded */
+static void
+add_placeholder (GtkTreeModel *model, GtkTreeIter *it, gchar *id)
+{
+  GtkTreeIter child;
+  GSList *c;
+  guint i;
+
+  gtk_tree_store_append (GTK_TREE_STORE (model), &child, it);
+  gtk_tree_store_set (GTK_TREE_STORE (model), &child, lazy_col, TRUE, -1);
+  for (c = options.list_data.columns, i = 0; c; c = c->next, i++)
+    {
+      YadColumn *col = (YadColumn *) c->data;
+      if (col->type == YAD_COLUMN_TEXT && i != options.list_data.hide_column - 1)
+        {
+          gtk_tree_store_set (GTK_TREE_STORE (model), &child, i, _("Loading..."), -1);
+          break;
+        }
+    }
+
+  g_hash_table_replace (lazy_hash, g_strdup (id), GINT_TO_POINTER (LAZY_WAIT));
+}
+
+/* add tree row from ROW-ID[:PARENT-ID] line. ids started with + marks nodes with lazy loaded children */
+static gboolean
+add_tree_row (GtkTreeModel *model, GtkTreeIter *it, gchar *line, gchar *def_parent)
+{
+  gchar **ids = g_strsplit (line, ":", 2);
+  gchar *id = ids[0];
+  gboolean lazy = FALSE;
+
+  if (lazy_hash && id[0] == '+')
+    {
+      lazy = TRUE;
+      id++;
+    }
+
+  if (def_parent && !(ids[1] && ids[1][0]))
+    {
+      /* parent of lazy loaded row must exist */
+      if (!g_hash_table_lookup (row_hash, def_parent))
+        {
+          g_strfreev (ids);
+          return FALSE;
+        }
+      yad_list_add_row (GTK_TREE_STORE (model), it, id, def_parent);
+    }
+  else
+    yad_list_add_row (GTK_TREE_STORE (model), it, id, ids[1]);
+
+  if (lazy && id[0])
+    add_placeholder (model, it, id);
+
+  g_strfreev (ids);
+
+  return TRUE;
+}
+
+/* remove placeholder from loaded node */
+static void
+clear_placeholder (GtkTreeModel *model, gchar *id)
+{
+  GtkTreeIter *it, child;
+
+  if ((it = g_hash_table_lookup (row_hash, id)) == NULL)
+    return;
+
+  if (gtk_tree_model_iter_children (model, &child, it))
+    {
+      gboolean valid = TRUE;
+
+      while (valid)
+        {
+          gboolean ph;
+
+          gtk_tree_model_get (model, &child, lazy_col, &ph, -1);
+          if (ph)
+            valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &child);
+          else
+            valid = gtk_tree_model_iter_next (model, &child);
+        }
+    }
+}
+
+static gboolean
+lazy_read_cb (GIOChannel *ch, GIOCondition cond, LazyLoad *ld)
+{
+  GtkTreeModel *model = list_store;
+  GIOStatus status;
+  gchar *line;
+
+  block_index_updates (TRUE);
+
+  while ((status = g_io_channel_read_line (ch, &line, NULL, NULL, NULL)) == G_IO_STATUS_NORMAL)
+    {
+      strip_new_line (line);
+
+      if (ld->col < 0)
+        {
+          g_free (ld->row_id);
+          ld->row_id = line;
+          ld->col = 0;
+          continue;
+        }
+
+      g_free (ld->row[ld->col]);
+      ld->row[ld->col++] = line;
+
+      if (ld->col == n_cols)
+        {
+          GtkTreeIter iter;
+          guint i;
+
+          if (!ld->cleared)
+            {
+              clear_placeholder (model, ld->id);
+              ld->cleared = TRUE;
+            }
+
+          if (add_tree_row (model, &iter, ld->row_id, ld->id))
+            {
+              for (i = 0; i < n_cols; i++)
+                cell_set_data (&iter, i, ld->row[i]);
+            }
+          ld->col = -1;
+        }
+    }
+
+  block_index_updates (FALSE);
+
+  if (status == G_IO_STATUS_AGAIN)
+    return TRUE;
+
+  /* loading is finished */
+  if (!ld->cleared)
+    clear_placeholder (model, ld->id);
+  if (g_hash_table_lookup (lazy_hash, ld->id))
+    g_hash_table_replace (lazy_hash, g_strdup (ld->id), GINT_TO_POINTER (LAZY_DONE));
+
+  g_io_channel_shutdown (ch, FALSE, NULL);
+  g_io_channel_unref (ch);
+
+  g_free (ld->id);
+  g_free (ld->row_id);
+  g_strfreev (ld->row);
+  g_free (ld);
+
+  return FALSE;
+}
+
+/* run expand command for node with lazy loaded children */
+static gboolean
+test_expand_cb (GtkTreeView *view, GtkTreeIter *it, GtkTreePath *path, gpointer data)
+{
+  GtkTreeModel *model = gtk_tree_view_get_model (view);
+  gchar *id, *qid, *cmd, *full_cmd, **argv = NULL;
+  gint out;
+  GError *err = NULL;
+
+  gtk_tree_model_get (model, it, id_col, &id, -1);
+  if (!id)
+    return FALSE;
+
+  /* children are already loaded or loading */
+  if (GPOINTER_TO_INT (g_hash_table_lookup (lazy_hash, id)) != LAZY_WAIT)
+    {
+      g_free (id);
+      return FALSE;
+    }
+
+  qid = g_shell_quote (id);
+  if (g_strstr_len (options.list_data.expand_cmd, -1, "%s"))
+    {
+      gchar **parts = g_strsplit (options.list_data.expand_cmd, "%s", -1);
+      cmd = g_strjoinv (qid, parts);
+      g_strfreev (parts);
+    }
+  else
+    cmd = g_strdup_printf ("%s %s", options.list_data.expand_cmd, qid);
+  g_free (qid);
+
+  full_cmd = get_full_cmd (cmd);
+  g_free (cmd);
+
+  if (g_shell_parse_argv (full_cmd, NULL, &argv, &err) &&
+      g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, NULL, NULL, &out, NULL, &err))
+    {
+      LazyLoad *ld;
+      GIOChannel *ch;
+
+      ld = g_new0 (LazyLoad, 1);
+      ld->id = g_strdup (id);
+      ld->row = g_new0 (gchar *, n_cols + 1);
+      ld->col = -1;
+
+      ch = g_io_channel_unix_new (out);
+      g_io_channel_set_encoding (ch, NULL, NULL);
+      g_io_channel_set_flags (ch, G_IO_FLAG_NONBLOCK, NULL);
+      g_io_channel_set_close_on_unref (ch, TRUE);
+      g_io_add_watch (ch, G_IO_IN | G_IO_HUP, (GIOFunc) lazy_read_cb, ld);
+
+      g_hash_table_replace (lazy_hash, id, GINT_TO_POINTER (LAZY_LOADING));
+    }
+  else
+    {
+      if (options.debug)
+        g_printerr (_("WARNING: Run command failed: %s\n"), err->message);
+      g_error_free (err);
+      g_free (id);
+    }
+
+  g_strfreev (argv);
+  g_free (full_cmd);
+
+  return FALSE;
+}
+
+/* scroll to the last visible row */
+static void
+scroll_to_tail ()
+{
+  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreePath *path;
+  GtkTreeIter iter, parent;
+  gint n;
+
+  if ((n = gtk_tree_model_iter_n_children (model, NULL)) == 0)
+    return;
+
+  if (options.list_data.add_on_top)
+    path = gtk_tree_path_new_first ();
+  else
+    {
+      gtk_tree_model_iter_nth_child (model, &iter, NULL, n - 1);
+      path = gtk_tree_model_get_path (model, &iter);
+      /* go down to the last expanded child */
+      while (gtk_tree_view_row_expanded (GTK_TREE_VIEW (list_view), path) &&
+             (n = gtk_tree_model_iter_n_children (model, &iter)) > 0)
+        {
+          parent = iter;
+          gtk_tree_model_iter_nth_child (model, &iter, &parent, n - 1);
+          gtk_tree_path_append_index (path, n - 1);
+        }
+    }
+
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (list_view), path, NULL, FALSE, 1.0, 1.0);
+  gtk_tree_path_free (path);
+}
+
+/* move collected rows to the model. evicted rows are removed in one pass */
+static void
+flush_ring ()
+{
+  GtkTreeModel *model = list_store;
+  GtkTreeSelection *sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list_view));
+  GtkTreeIter iter;
+  gint n, evict;
+  guint i, j;
+
+  if (ring_len == 0)
+    return;
+
+  if (select_hndl)
+    g_signal_handler_block (G_OBJECT (sel), select_hndl);
+
+  n = gtk_tree_model_iter_n_children (model, NULL);
+  evict = n + (gint) ring_len - (gint) options.list_data.limit;
+  if (evict > 0 && options.list_data.add_on_top)
+    {
+#if GTK_CHECK_VERSION(3,0,0)
+      /* find the last row once and go back from it */
+      gtk_tree_model_iter_nth_child (model, &iter, NULL, n - 1);
+      while (evict-- > 0)
+        {
+          GtkTreeIter prev = iter;
+          gboolean more = gtk_tree_model_iter_previous (model, &prev);
+
+          remove_row (model, &iter);
+          if (!more)
+            break;
+          iter = prev;
+        }
+#else
+      while (evict-- > 0)
+        {
+          gtk_tree_model_iter_nth_child (model, &iter, NULL, --n);
+          remove_row (model, &iter);
+        }
+#endif
+    }
+  else
+    {
+      while (evict-- > 0)
+        {
+          gtk_tree_model_get_iter_first (model, &iter);
+          remove_row (model, &iter);
+        }
+    }
+
+  for (i = 0; i < ring_len; i++)
+    {
+      gchar **row = ring[(ring_start + i) % options.list_data.limit];
+
+      if (options.list_data.add_on_top)
+        gtk_tree_store_prepend (GTK_TREE_STORE (model), &iter, NULL);
+      else
+        gtk_tree_store_append (GTK_TREE_STORE (model), &iter, NULL);
+      for (j = 0; j < n_cols; j++)
+        cell_set_data (&iter, j, row[j]);
+      g_strfreev (row);
+    }
+  ring_start = ring_len = 0;
+
+  if (select_hndl)
+    g_signal_handler_unblock (G_OBJECT (sel), select_hndl);
+
+  if (options.common_data.tail)
+    scroll_pending = TRUE;
+}
+
+/* add row to the ring. the oldest row is dropped on overflow */
+static void
+ring_add_row (gchar **row)
+{
+  guint pos;
+
+  if (ring_len == options.list_data.limit)
+    {
+      g_strfreev (ring[ring_start]);
+      ring[ring_start] = row;
+      ring_start = (ring_start + 1) % options.list_data.limit;
+    }
+  else
+    {
+      pos = (ring_start + ring_len) % options.list_data.limit;
+      ring[pos] = row;
+      ring_len++;
+    }
+
+  schedule_update ();
+}
+
+static void
+ring_clear ()
+{
+  guint i;
+
+  for (i = 0; i < ring_len; i++)
+    g_strfreev (ring[(ring_start + i) % options.list_data.limit]);
+  ring_start = ring_len = 0;
+}
+
+/* expand parents of rows added since last frame */
+static void
+expand_parents ()
+{
+  GtkTreeModel *model = list_store;
+  GHashTableIter hit;
+  gpointer id;
+
+  g_hash_table_iter_init (&hit, expand_set);
+  while (g_hash_table_iter_next (&hit, &id, NULL))
+    {
+      GtkTreeIter *it = g_hash_table_lookup (row_hash, id);
+
+      if (it)
+        {
+          GtkTreePath *path = gtk_tree_model_get_path (model, it);
+
+          if (filter_model)
+            {
+              GtkTreePath *vpath = gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (filter_model), path);
+              gtk_tree_path_free (path);
+              path = vpath;
+            }
+          /* row may be hidden by filter */
+          if (path)
+            {
+              gtk_tree_view_expand_to_path (GTK_TREE_VIEW (list_view), path);
+              gtk_tree_path_free (path);
+            }
+        }
+    }
+  g_hash_table_remove_all (expand_set);
+}
+
+static gboolean
+update_view (gpointer data)
+{
+  update_pending = FALSE;
+
+  if (ring)
+    flush_ring ();
+
+  if (expand_set)
+    expand_parents ();
+
+  if (scroll_pending)
+    {
+      scroll_to_tail ();
+      scroll_pending = FALSE;
+    }
+
+  return FALSE;
+}
+
+#if GTK_CHECK_VERSION(3,8,0)
+static gboolean
+update_tick_cb (GtkWidget *w, GdkFrameClock *clock, gpointer data)
+{
+  return update_view (data);
+}
+#endif
+
+/* run deferred view updates before drawing of next frame */
+static void
+schedule_update ()
+{
+  if (update_pending)
+    return;
+
+  update_pending = TRUE;
+#if GTK_CHECK_VERSION(3,8,0)
+  gtk_widget_add_tick_callback (list_view, update_tick_cb, NULL, NULL);
+#else
+  g_idle_add (update_view, NULL);
+#endif
+}
+
+static void start_snapshot (GPtrArray *rows);
+
+static gboolean
+snapshot_done (SnapJob *job)
+{
+  GtkTreeModel *model = list_store;
+  GtkTreeSelection *sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list_view));
+  guint i, j, k = options.list_data.key_column - 1;
+
+  /* apply edit script at once */
+  if (select_hndl)
+    g_signal_handler_block (G_OBJECT (sel), select_hndl);
+  block_index_updates (TRUE);
+
+  /* remove rows first, so new rows are placed between the remaining ones */
+  for (i = 0; i < job->ops->len; i++)
+    {
+      SnapOp *op = &g_array_index (job->ops, SnapOp, i);
+      GtkTreeIter *it;
+
+      if (op->key && (it = g_hash_table_lookup (key_hash, op->key)) != NULL)
+        {
+          GtkTreeIter iter = *it;
+          remove_row (model, &iter);
+        }
+    }
+
+  for (i = 0; i < job->ops->len; i++)
+    {
+      SnapOp *op = &g_array_index (job->ops, SnapOp, i);
+      GtkTreeIter *it;
+
+      if (op->key)
+        continue;
+
+      it = g_hash_table_lookup (key_hash, op->vals[k]);
+      if (!it)
+        insert_snapshot_row (model, op->vals, op->prev);
+      else
+        {
+          for (j = 0; j < n_cols; j++)
+            {
+              if (!op->changed || op->changed[j])
+                update_cell (it, j, op->vals[j]);
+            }
+        }
+      g_free (op->changed);
+    }
+  trim_rows (model);
+
+  block_index_updates (FALSE);
+  if (select_hndl)
+    g_signal_handler_unblock (G_OBJECT (sel), select_hndl);
+
+  g_array_free (job->ops, TRUE);
+  g_hash_table_unref (job->old);
+  snap_cur = job->snap;
+  g_free (job);
+  snap_busy = FALSE;
+
+  /* diff the latest received snapshot */
+  if (snap_pending)
+    {
+      GPtrArray *rows = snap_pending;
+      snap_pending = NULL;
+      start_snapshot (rows);
+    }
+
+  return FALSE;
+}
+
+/* compare snapshot with the previous one and make edit script */
+static gpointer
+snapshot_thread (SnapJob *job)
+{
+  GHashTableIter hit;
+  gpointer key, val;
+  gchar *prev = NULL;
+  guint i, j, k = options.list_data.key_column - 1;
+
+  job->snap = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_strfreev);
+  job->ops = g_array_new (FALSE, TRUE, sizeof (SnapOp));
+
+  for (i = 0; i < job->rows->len; i++)
+    {
+      gchar **row = g_ptr_array_index (job->rows, i);
+      gchar **old;
+      SnapOp op = { NULL, row, NULL, prev };
+
+      /* first row with the same key wins */
+      if (g_hash_table_lookup (job->snap, row[k]))
+        {
+          g_strfreev (row);
+          continue;
+        }
+      g_hash_table_insert (job->snap, row[k], row);
+      prev = row[k];
+
+      if ((old = g_hash_table_lookup (job->old, row[k])) != NULL)
+        {
+          gboolean diff = FALSE;
+
+          op.changed = g_new0 (guint8, n_cols);
+          for (j = 0; j < n_cols; j++)
+            {
+              if (strcmp (old[j], row[j]) != 0)
+                op.changed[j] = diff = TRUE;
+            }
+          if (!diff)
+            {
+              g_free (op.changed);
+              continue;
+            }
+        }
+      g_array_append_val (job->ops, op);
+    }
+  /* rows are owned by new snapshot now */
+  g_ptr_array_set_free_func (job->rows, NULL);
+  g_ptr_array_free (job->rows, TRUE);
+
+  g_hash_table_iter_init (&hit, job->old);
+  while (g_hash_table_iter_next (&hit, &key, &val))
+    {
+      if (!g_hash_table_lookup (job->snap, key))
+        {
+          SnapOp op = { key, NULL, NULL, NULL };
+          g_array_append_val (job->ops, op);
+        }
+    }
+
+  g_idle_add ((GSourceFunc) snapshot_done, job);
+
+  return NULL;
+}
+
+static void
+start_snapshot (GPtrArray *rows)
+{
+  SnapJob *job;
+
+  /* only the latest snapshot waits for diffing */
+  if (snap_busy)
+    {
+      if (snap_pending)
+        g_ptr_array_free (snap_pending, TRUE);
+      snap_pending = rows;
+      return;
+    }
+
+  snap_busy = TRUE;
+
+  job = g_new0 (SnapJob, 1);
+  job->old = snap_cur;
+  job->rows = rows;
+  snap_cur = NULL;
+
+  g_thread_unref (g_thread_new ("snapshot", (GThreadFunc) snapshot_thread, job));
+}
+
+static void check_pages (void);
+
+static void
+page_loaded (gint ret, gchar *out, gpointer data)
+{
+  guint page = GPOINTER_TO_UINT (data);
 
-          if (col->type == YAD_COLUMN_TIP)
-            options.list_data.tooltip_column = i + 1;
-          break;
-        }
-      g_object_set_data (G_OBJECT (renderer), "column", GINT_TO_POINTER (i));
-      gtk_tree_view_append_column (GTK_TREE_VIEW (list_view), column);
+  g_hash_table_remove (page_loading, data);
 
-      gtk_tree_view_column_set_clickable (column, options.list_data.clickable);
+  /* pages which are far from view are not needed anymore */
+  if (page + 1 < first_page || page > first_page + n_pages)
+    return;
 
-      if (col->type != YAD_COLUMN_CHECK && col->type != YAD_COLUMN_IMAGE)
+  if (ret != 0 && options.debug)
+    g_printerr (_("WARNING: page command returns %d\n"), ret);
+
+  g_hash_table_replace (page_cache, data, g_strdup (out ? out : ""));
+  check_pages ();
+}
+
+/* load page in background */
+static void
+request_page (guint page)
+{
+  gpointer key = GUINT_TO_POINTER (page);
+  gchar *cmd;
+
+  if (last_page != -1 && page > (guint) last_page)
+    return;
+  if (g_hash_table_contains (page_cache, key) || g_hash_table_contains (page_loading, key))
+    return;
+
+  g_hash_table_add (page_loading, key);
+
+  cmd = g_strdup_printf ("%s %u %u", options.list_data.page_cmd,
+                         page * options.list_data.page_size, options.list_data.page_size);
+  run_command_cb (cmd, page_loaded, key);
+  g_free (cmd);
+}
+
+/* insert page rows at position pos. returns number of rows */
+static guint
+insert_page (GtkTreeModel *model, guint page, gchar *data, gint pos)
+{
+  gchar **lines = g_strsplit (data, "\n", 0);
+  guint i, j, len, n = 0;
+
+  /* drop the empty element after final newline. empty cells inside are kept */
+  len = g_strv_length (lines);
+  if (len > 0 && !lines[len - 1][0])
+    len--;
+
+  for (i = 0; i < len && n < options.list_data.page_size; n++)
+    {
+      GtkTreeIter iter;
+
+      gtk_tree_store_insert_with_values (GTK_TREE_STORE (model), &iter, NULL, pos < 0 ? -1 : pos + n,
+                                         page_col, page, -1);
+      for (j = 0; j < n_cols && i < len; j++, i++)
+        cell_set_data (&iter, j, lines[i]);
+    }
+  g_strfreev (lines);
+
+  return n;
+}
+
+/* height of shown page rows. if above is TRUE only rows above the visible area are counted.
+   walks the whole store, which is bounded by max pages */
+static gint
+page_height (GtkTreeModel *model, guint page, gboolean above)
+{
+  GtkTreeIter iter;
+  gint h = 0;
+
+  if (!gtk_tree_model_get_iter_first (model, &iter))
+    return 0;
+
+  do
+    {
+      GtkTreePath *path;
+      guint p;
+
+      gtk_tree_model_get (model, &iter, page_col, &p, -1);
+      if (p != page)
+        continue;
+
+      path = gtk_tree_model_get_path (model, &iter);
+      if (filter_model)
         {
-          if (i == options.list_data.expand_column - 1 || options.list_data.expand_column == 0)
-            gtk_tree_view_column_set_expand (column, TRUE);
+          GtkTreePath *vpath = gtk_tree_model_filter_convert_child_path_to_path (GTK_TREE_MODEL_FILTER (filter_model), path);
+          gtk_tree_path_free (path);
+          path = vpath;
+        }
+      if (path)
+        {
+          GdkRectangle r;
+
+          gtk_tree_view_get_background_area (GTK_TREE_VIEW (list_view), path, NULL, &r);
+          if (!above || r.y < 0)
+            h += r.height;
+          gtk_tree_path_free (path);
         }
     }
+  while (gtk_tree_model_iter_next (model, &iter));
 
-  if(options.list_data.search_column < 0)
-    options.list_data.search_column = 0;
-  if (options.list_data.search_column <= n_cols)
-    gtk_tree_view_set_search_column (GTK_TREE_VIEW (list_view), options.list_data.search_column - 1);
+  return h;
 }
 
+/* remove rows of page wherever they are. walks the whole store, which is bounded by max pages */
 static void
-cell_set_data (GtkTreeIter *it, guint num, gchar *data)
+remove_page (GtkTreeModel *model, guint page)
 {
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
-  YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, num);
+  GtkTreeIter iter;
+  gboolean valid;
 
-  switch (col->type)
+  valid = gtk_tree_model_get_iter_first (model, &iter);
+  while (valid)
     {
-    case YAD_COLUMN_CHECK:
-    case YAD_COLUMN_RADIO:
-        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, get_bool_val (data), -1);
-      break;
-    case YAD_COLUMN_NUM:
-    case YAD_COLUMN_SIZE:
-      gtk_tree_store_set (GTK_TREE_STORE (model), it, num, g_ascii_strtoll (data, NULL, 10), -1);
-      break;
-    case YAD_COLUMN_FLOAT:
-      gtk_tree_store_set (GTK_TREE_STORE (model), it, num, g_ascii_strtod (data, NULL), -1);
-      break;
-    case YAD_COLUMN_BAR:
-      {
-        gint64 val = g_ascii_strtoll (data, NULL, 10);
-        if (val < 0)
-          val = 0;
-        if (val > 100)
-          val = 100;
-        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, val, -1);
-        break;
-      }
-    case YAD_COLUMN_IMAGE:
-      {
-        gboolean b;
-        GdkPixbuf *pb;
-        GtkStockItem sit;
-        SETUNDEPR (b, gtk_stock_lookup, data, &sit);
-        if (b)
-          {
-            SETUNDEPR (pb, gtk_widget_render_icon, list_view, sit.stock_id, GTK_ICON_SIZE_MENU, "");
-          }
-        else
-          {
-            pb = get_pixbuf (data, YAD_SMALL_ICON, FALSE);
-          }
-        if (pb)
-          {
-            gtk_tree_store_set (GTK_TREE_STORE (model), it, num, pb, -1);
-            g_object_unref (pb);
-          }
-        break;
-      }
-    default:
-      if (data && *data)
-        gtk_tree_store_set (GTK_TREE_STORE (model), it, num, data, -1);
-      break;
+      guint p;
+
+      gtk_tree_model_get (model, &iter, page_col, &p, -1);
+      if (p == page)
+        valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+      else
+        valid = gtk_tree_model_iter_next (model, &iter);
     }
 }
 
-static gchar *
-cell_get_data (GtkTreeIter *it, guint num)
+/* load pages near the visible area and drop far ones */
+static void
+check_pages ()
 {
-  gchar *data = NULL;
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
-  YadColumn *col = (YadColumn *) g_slist_nth_data (options.list_data.columns, num);
+  GtkTreeModel *model = list_store;
+  gdouble val, size, upper;
+  gchar *data;
+  guint next, n;
+
+  val = gtk_adjustment_get_value (page_adj);
+  size = gtk_adjustment_get_page_size (page_adj);
+  upper = gtk_adjustment_get_upper (page_adj);
+
+  /* scrolled to the end */
+  next = first_page + n_pages;
+  if (val + 2 * size >= upper && (last_page == -1 || next <= (guint) last_page))
+    {
+      if ((data = g_hash_table_lookup (page_cache, GUINT_TO_POINTER (next))) != NULL)
+        {
+          n = insert_page (model, next, data, -1);
+          g_hash_table_remove (page_cache, GUINT_TO_POINTER (next));
+          if (n < options.list_data.page_size)
+            last_page = next;
+          n_pages++;
+
+          /* drop the first page */
+          if (options.list_data.max_pages && n_pages > options.list_data.max_pages)
+            {
+              gint h = page_height (model, first_page, TRUE);
 
-  switch (col->type)
+              remove_page (model, first_page);
+              first_page++;
+              n_pages--;
+              gtk_adjustment_set_value (page_adj, MAX (val - h, 0));
+            }
+        }
+
+      /* prefetch the next page */
+      request_page (first_page + n_pages);
+    }
+  /* scrolled to the beginning */
+  else if (val <= size && first_page > 0)
     {
-    case YAD_COLUMN_CHECK:
-    case YAD_COLUMN_RADIO:
-      {
-        gboolean bval;
-        gtk_tree_model_get (model, it, num, &bval, -1);
-        data = g_strdup (print_bool_val (bval));
-        break;
-      }
-    case YAD_COLUMN_NUM:
-    case YAD_COLUMN_SIZE:
-    case YAD_COLUMN_BAR:
-      {
-        gint64 nval;
-        gtk_tree_model_get (model, it, num, &nval, -1);
-        data = g_strdup_printf ("%ld", (long) nval);
-        break;
-      }
-    case YAD_COLUMN_FLOAT:
-      {
-        gdouble nval;
-        gtk_tree_model_get (model, it, num, &nval, -1);
-        data = g_strdup_printf ("%lf", nval);
-        break;
-      }
-    case YAD_COLUMN_IMAGE:
-      {
-        data = g_strdup ("''");
-        break;
-      }
-    default:
-      {
-        gchar *cval;
-        gtk_tree_model_get (model, it, num, &cval, -1);
-        if (cval)
-          data = g_shell_quote (cval);
-        break;
-      }
+      next = first_page - 1;
+      if ((data = g_hash_table_lookup (page_cache, GUINT_TO_POINTER (next))) != NULL)
+        {
+          insert_page (model, next, data, 0);
+          g_hash_table_remove (page_cache, GUINT_TO_POINTER (next));
+          first_page--;
+          n_pages++;
+
+          /* drop the last page */
+          if (options.list_data.max_pages && n_pages > options.list_data.max_pages)
+            {
+              remove_page (model, first_page + n_pages - 1);
+              if (last_page == (gint) (first_page + n_pages - 1))
+                last_page = -1;
+              n_pages--;
+            }
+
+          /* keep the visible rows in place */
+          gtk_adjustment_set_value (page_adj, val + page_height (model, first_page, FALSE));
+        }
+
+      if (first_page > 0)
+        request_page (first_page - 1);
     }
+}
 
-  return data;
+static void
+page_adj_cb (GtkAdjustment *adj, gpointer data)
+{
+  check_pages ();
 }
 
 static gboolean
@@ -574,7 +2482,7 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
   static GtkTreeIter iter;
   static gint column_count = 0;
   static gint row_count = 0;
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
 
   if ((condition == G_IO_IN) || (condition == G_IO_IN + G_IO_HUP))
     {
@@ -585,6 +2493,8 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
       while (channel->is_readable != TRUE)
         usleep (100);
 
+      block_index_updates (TRUE);
+
       do
         {
           gint status;
@@ -606,13 +2516,29 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
                   g_error_free (err);
                   err = NULL;
                 }
+              /* apply the last snapshot */
+              if (snap_rows && snap_rows->len > 0)
+                {
+                  start_snapshot (snap_rows);
+                  snap_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+                }
               /* stop handling */
+              block_index_updates (FALSE);
               g_io_channel_shutdown (channel, TRUE, NULL);
               return FALSE;
             }
 
           strip_new_line (string->str);
 
+          /* in snapshot mode ^L finishes snapshot */
+          if (snap_rows && string->str[0] == '\014')
+            {
+              start_snapshot (snap_rows);
+              snap_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+              column_count = 0;
+              continue;
+            }
+
           /* clear list if ^L received */
           if (string->str[0] == '\014')
             {
@@ -623,19 +2549,64 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
               row_count = column_count = 0;
               if (row_hash)
                 g_hash_table_remove_all (row_hash);
+              if (lazy_hash)
+                g_hash_table_remove_all (lazy_hash);
+              if (key_hash)
+                g_hash_table_remove_all (key_hash);
+              if (ring)
+                ring_clear ();
               if (select_hndl)
                 g_signal_handler_unblock (G_OBJECT (sel), select_hndl);
               continue;
             }
 
+          /* keyed input. rows are collected and applied when complete */
+          if (key_hash)
+            {
+              if (string->str[0] == '\033' && !snap_rows)
+                run_key_command (model, string->str + 1);
+              else
+                {
+                  g_free (row_buf[column_count]);
+                  row_buf[column_count] = g_strdup (string->str);
+                  column_count++;
+                  if (column_count == n_cols)
+                    {
+                      if (snap_rows)
+                        {
+                          g_ptr_array_add (snap_rows, row_buf);
+                          row_buf = g_new0 (gchar *, n_cols + 1);
+                        }
+                      else
+                        upsert_row (model, row_buf);
+                      column_count = 0;
+                    }
+                }
+              continue;
+            }
+
+          /* limited list. rows are collected in ring */
+          if (ring)
+            {
+              g_free (row_buf[column_count]);
+              row_buf[column_count] = g_strdup (string->str);
+              column_count++;
+              if (column_count == n_cols)
+                {
+                  ring_add_row (row_buf);
+                  row_buf = g_new0 (gchar *, n_cols + 1);
+                  column_count = 0;
+                }
+              continue;
+            }
+
           if (row_count == 0 && column_count == 0)
             {
               if (options.list_data.tree_mode)
                 {
                   if (!node_added)
                     {
-                      gchar **ids = g_strsplit (string->str, ":", 2);
-                      yad_list_add_row (GTK_TREE_STORE (model), &iter, ids[0], ids[1]);
+                      add_tree_row (model, &iter, string->str, NULL);
                       node_added = TRUE;
                       continue;
                     }
@@ -652,8 +2623,7 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
                 {
                   if (!node_added)
                     {
-                      gchar **ids = g_strsplit (string->str, ":", 2);
-                      yad_list_add_row (GTK_TREE_STORE (model), &iter, ids[0], ids[1]);
+                      add_tree_row (model, &iter, string->str, NULL);
                       node_added = TRUE;
                       continue;
                     }
@@ -666,8 +2636,10 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
               row_count++;
               if (options.list_data.limit && row_count >= options.list_data.limit)
                 {
-                  gtk_tree_model_get_iter_first (model, &iter);
-                  gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+                  GtkTreeIter first;
+
+                  gtk_tree_model_get_iter_first (model, &first);
+                  remove_row (model, &first);
                 }
             }
 
@@ -676,10 +2648,9 @@ handle_stdin (GIOChannel *channel, GIOCondition condition, gpointer data)
         }
       while (g_io_channel_get_buffer_condition (channel) == G_IO_IN);
       g_string_free (string, TRUE);
-    }
 
-  if (options.list_data.tree_expanded)
-    gtk_tree_view_expand_all (GTK_TREE_VIEW (list_view));
+      block_index_updates (FALSE);
+    }
 
   if ((condition != G_IO_IN) && (condition != G_IO_IN + G_IO_HUP))
     {
@@ -694,24 +2665,56 @@ static void
 fill_data ()
 {
   GtkTreeIter iter;
-  GtkTreeStore *model = GTK_TREE_STORE (gtk_tree_view_get_model (GTK_TREE_VIEW (list_view)));
+  GtkTreeStore *model = GTK_TREE_STORE (list_store);
   GIOChannel *channel;
 
+  /* data is loaded by pages */
+  if (options.list_data.page_cmd && !options.list_data.tree_mode)
+    {
+      page_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+      page_loading = g_hash_table_new (g_direct_hash, g_direct_equal);
+      g_signal_connect (G_OBJECT (page_adj), "value-changed", G_CALLBACK (page_adj_cb), NULL);
+      g_signal_connect (G_OBJECT (page_adj), "changed", G_CALLBACK (page_adj_cb), NULL);
+      request_page (0);
+      return;
+    }
+
   if (options.extra_data && *options.extra_data)
     {
       gchar **args = options.extra_data;
       gint i = 0;
 
       gtk_widget_freeze_child_notify (list_view);
+      block_index_updates (TRUE);
 
       while (args[i] != NULL)
         {
           gint j;
 
+          if (key_hash)
+            {
+              /* add rows through key index */
+              for (j = 0; j < n_cols && args[i]; j++, i++)
+                {
+                  g_free (row_buf[j]);
+                  row_buf[j] = g_strdup (args[i]);
+                }
+              if (j == n_cols)
+                {
+                  if (snap_rows)
+                    {
+                      g_ptr_array_add (snap_rows, row_buf);
+                      row_buf = g_new0 (gchar *, n_cols + 1);
+                    }
+                  else
+                    upsert_row (GTK_TREE_MODEL (model), row_buf);
+                }
+              continue;
+            }
+
           if (options.list_data.tree_mode)
             {
-              gchar **ids = g_strsplit (args[i], ":", 2);
-              yad_list_add_row (model, &iter, ids[0], ids[1]);
+              add_tree_row (GTK_TREE_MODEL (model), &iter, args[i], NULL);
               i++;
             }
           else
@@ -725,7 +2728,15 @@ fill_data ()
             }
         }
 
+      block_index_updates (FALSE);
       gtk_widget_thaw_child_notify (list_view);
+
+      /* command line data is the first snapshot */
+      if (snap_rows && snap_rows->len > 0)
+        {
+          start_snapshot (snap_rows);
+          snap_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+        }
     }
 
   if (options.common_data.listen || !(options.extra_data && *options.extra_data))
@@ -771,13 +2782,13 @@ double_click_cb (GtkTreeView *view, GtkTreePath *path, GtkTreeViewColumn *column
   GtkTreeModel *model;
   GtkTreeIter iter;
 
-  model = gtk_tree_view_get_model (view);
+  model = list_store;
 
   if (options.list_data.dclick_action)
     {
       gchar *cmd, *args = NULL;
 
-      if (gtk_tree_model_get_iter (model, &iter, path))
+      if (view_get_iter (&iter, path))
         args = get_data_as_string (&iter);
       else
         args = g_strdup ("");
@@ -827,7 +2838,7 @@ double_click_cb (GtkTreeView *view, GtkTreePath *path, GtkTreeViewColumn *column
     {
       if (options.list_data.checkbox)
         {
-          if (gtk_tree_model_get_iter (model, &iter, path))
+          if (view_get_iter (&iter, path))
             {
               gboolean chk;
 
@@ -838,7 +2849,7 @@ double_click_cb (GtkTreeView *view, GtkTreePath *path, GtkTreeViewColumn *column
         }
       else if (options.list_data.radiobox)
         {
-          if (gtk_tree_model_get_iter (model, &iter, path))
+          if (view_get_iter (&iter, path))
             {
               gtk_tree_model_foreach (model, runtoggle, GINT_TO_POINTER (0));
               gtk_tree_store_set (GTK_TREE_STORE (model), &iter, 0, TRUE, -1);
@@ -858,6 +2869,7 @@ select_cb (GtkTreeSelection *sel, gpointer data)
 
   if (!gtk_tree_selection_get_selected (sel, &model, &iter))
     return;
+  to_store_iter (&iter);
 
   args = get_data_as_string (&iter);
   if (!args)
@@ -887,14 +2899,17 @@ add_row_cb (GtkMenuItem *item, gpointer data)
   GtkTreeIter iter;
   gchar *cmd;
 
-  model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  model = list_store;
   if (g_object_get_data (G_OBJECT (item), "child") != NULL)
     {
       GtkTreeIter parent;
       GtkTreeSelection *sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list_view));
 
       if (gtk_tree_selection_get_selected (sel, NULL, &parent))
-        gtk_tree_store_append (GTK_TREE_STORE (model), &iter, &parent);
+        {
+          to_store_iter (&parent);
+          gtk_tree_store_append (GTK_TREE_STORE (model), &iter, &parent);
+        }
       else
         gtk_tree_store_append (GTK_TREE_STORE (model), &iter, NULL);
     }
@@ -944,6 +2959,7 @@ edit_row_cb (GtkMenuItem *item, gpointer data)
 
   if (!gtk_tree_selection_get_selected (sel, NULL, &iter))
     return;
+  to_store_iter (&iter);
 
   if (options.list_data.row_action)
     {
@@ -986,11 +3002,12 @@ static void
 del_row_cb (GtkMenuItem *item, gpointer data)
 {
   GtkTreeIter iter;
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
   GtkTreeSelection *sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list_view));
 
   if (gtk_tree_selection_get_selected (sel, NULL, &iter))
     {
+      to_store_iter (&iter);
       if (options.list_data.row_action)
         {
           gchar *cmd, *args;
@@ -1008,10 +3025,10 @@ del_row_cb (GtkMenuItem *item, gpointer data)
           exit = run_command_sync (cmd, NULL, list_view);
           g_free (cmd);
           if (exit == 0)
-            gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+            remove_row (model, &iter);
         }
       else
-        gtk_tree_store_remove (GTK_TREE_STORE (model), &iter);
+        remove_row (model, &iter);
     }
 }
 
@@ -1019,7 +3036,7 @@ static void
 copy_row_cb (GtkMenuItem *item, gpointer data)
 {
   GtkTreeIter iter;
-  GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  GtkTreeModel *model = list_store;
   GtkTreeSelection *sel = gtk_tree_view_get_selection (GTK_TREE_VIEW (list_view));
 
   if (gtk_tree_selection_get_selected (sel, NULL, &iter))
@@ -1027,6 +3044,8 @@ copy_row_cb (GtkMenuItem *item, gpointer data)
       GtkTreeIter new_iter, parent;
       gint i;
 
+      to_store_iter (&iter);
+
       if (gtk_tree_model_iter_parent (model, &parent, &iter))
         gtk_tree_store_insert_after (GTK_TREE_STORE (model), &new_iter, &parent, &iter);
       else
@@ -1116,6 +3135,15 @@ popup_menu_cb (GtkWidget *w, GdkEventButton *ev, gpointer data)
           gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
           g_signal_connect (G_OBJECT (item), "activate", G_CALLBACK (copy_row_cb), menu);
 
+          item = gtk_separator_menu_item_new ();
+          gtk_widget_show (item);
+          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
+
+          item = gtk_menu_item_new_with_label (_("Print..."));
+          gtk_widget_show (item);
+          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
+          g_signal_connect_swapped (G_OBJECT (item), "activate", G_CALLBACK (print_list), NULL);
+
           gtk_widget_show (menu);
         }
 #if GTK_CHECK_VERSION(3,22,0)
@@ -1272,7 +3300,29 @@ list_create_widget (GtkWidget *dlg)
     }
 
   if (options.list_data.tree_mode)
-    row_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) gtk_tree_path_free);
+    {
+      row_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+      if (options.list_data.tree_expanded)
+        expand_set = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      if (options.list_data.expand_cmd)
+        lazy_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    }
+  else if (options.list_data.key_column > 0 && options.list_data.key_column <= n_cols)
+    {
+      key_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+      row_buf = g_new0 (gchar *, n_cols + 1);
+
+      if (options.list_data.snapshot)
+        {
+          snap_cur = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_strfreev);
+          snap_rows = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+        }
+    }
+  else if (options.list_data.limit)
+    {
+      ring = g_new0 (gchar **, options.list_data.limit);
+      row_buf = g_new0 (gchar *, n_cols + 1);
+    }
 
   parse_cols_props ();
 
@@ -1281,7 +3331,18 @@ list_create_widget (GtkWidget *dlg)
   gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (w), GTK_SHADOW_ETCHED_IN);
   gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (w), options.hscroll_policy, options.vscroll_policy);
 
-  model = create_model ();
+  model = list_store = create_model ();
+
+  /* rows are shown through filter */
+  if (options.list_data.filter_bar)
+    {
+      /* text cache must be updated before filter checks the row */
+      g_signal_connect (G_OBJECT (list_store), "row-changed", G_CALLBACK (text_changed_cb), NULL);
+      filter_model = gtk_tree_model_filter_new (list_store, NULL);
+      gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter_model), row_visible, NULL, NULL);
+      g_object_unref (list_store);
+      model = filter_model;
+    }
 
   list_view = gtk_tree_view_new_with_model (model);
   gtk_widget_set_name (list_view, "yad-list-widget");
@@ -1293,10 +3354,29 @@ list_create_widget (GtkWidget *dlg)
   gtk_tree_view_set_reorderable (GTK_TREE_VIEW (list_view), options.common_data.editable);
   g_object_unref (model);
 
+  if ((row_hash || key_hash) && options.common_data.editable)
+    changed_hndl = g_signal_connect (G_OBJECT (list_store), "row-changed", G_CALLBACK (row_changed_cb), NULL);
+
+  /* sorted list is reordered in background after changes */
+  if (options.list_data.clickable)
+    {
+      g_signal_connect (G_OBJECT (list_store), "row-inserted", G_CALLBACK (row_inserted_cb), NULL);
+      g_signal_connect (G_OBJECT (list_store), "row-deleted", G_CALLBACK (rows_changed_cb), NULL);
+      g_signal_connect (G_OBJECT (list_store), "row-changed", G_CALLBACK (sort_value_changed_cb), NULL);
+    }
+
   gtk_container_add (GTK_CONTAINER (w), list_view);
+  page_adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (w));
 
   add_columns ();
 
+  /* print list contents by Ctrl+P */
+  g_signal_connect (G_OBJECT (list_view), "key-press-event", G_CALLBACK (list_key_cb), NULL);
+
+  /* load children of tree nodes on demand */
+  if (lazy_hash)
+    g_signal_connect (G_OBJECT (list_view), "test-expand-row", G_CALLBACK (test_expand_cb), NULL);
+
   /* add popup menu */
   if (options.common_data.editable)
     g_signal_connect_swapped (G_OBJECT (list_view), "button_press_event", G_CALLBACK (popup_menu_cb), NULL);
@@ -1320,7 +3400,17 @@ list_create_widget (GtkWidget *dlg)
                                                        options.list_data.search_column);
 
       if (col->type == YAD_COLUMN_TEXT)
-        gtk_tree_view_set_search_equal_func (GTK_TREE_VIEW (list_view), regex_search, NULL, NULL);
+        {
+          RegexSearch *rs = g_new0 (RegexSearch, 1);
+
+          rs->cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+          rs->model = g_object_ref (list_store);
+          rs->hndl[0] = g_signal_connect (G_OBJECT (list_store), "row-changed", G_CALLBACK (regex_row_changed), rs);
+          rs->hndl[1] = g_signal_connect (G_OBJECT (list_store), "row-inserted", G_CALLBACK (regex_row_changed), rs);
+          rs->hndl[2] = g_signal_connect (G_OBJECT (list_store), "row-deleted", G_CALLBACK (regex_row_deleted), rs);
+          gtk_tree_view_set_search_equal_func (GTK_TREE_VIEW (list_view), (GtkTreeViewSearchEqualFunc) regex_search,
+                                               rs, (GDestroyNotify) free_regex_search);
+        }
     }
 
   /* add row separator function */
@@ -1350,8 +3440,29 @@ list_create_widget (GtkWidget *dlg)
   /* load data */
   fill_data ();
 
-  if (options.list_data.tree_expanded)
-    gtk_tree_view_expand_all (GTK_TREE_VIEW (list_view));
+  /* add filter bar above the list */
+  if (filter_model)
+    {
+      GtkWidget *box, *entry;
+
+#if !GTK_CHECK_VERSION(3,0,0)
+      box = gtk_vbox_new (FALSE, 2);
+#else
+      box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 2);
+#endif
+
+#if GTK_CHECK_VERSION(3,6,0)
+      entry = gtk_search_entry_new ();
+#else
+      entry = gtk_entry_new ();
+#endif
+      gtk_widget_set_name (entry, "yad-list-filter");
+      gtk_box_pack_start (GTK_BOX (box), entry, FALSE, FALSE, 0);
+      g_signal_connect (G_OBJECT (entry), "changed", G_CALLBACK (filter_changed_cb), NULL);
+
+      gtk_box_pack_start (GTK_BOX (box), w, TRUE, TRUE, 0);
+      w = box;
+    }
 
   return w;
 }
@@ -1449,6 +3560,16 @@ print_all (GtkTreeModel *model, GtkTreeIter *parent)
     {
       do
         {
+          /* skip placeholders of not loaded nodes */
+          if (lazy_hash)
+            {
+              gboolean ph;
+
+              gtk_tree_model_get (model, &iter, lazy_col, &ph, -1);
+              if (ph)
+                continue;
+            }
+
           for (i = 0; i < n_cols; i++)
             print_col (model, &iter, i);
           g_printf ("\n");
@@ -1465,7 +3586,11 @@ list_print_result (void)
   GtkTreeModel *model;
   gint col = options.list_data.print_column;
 
-  model = gtk_tree_view_get_model (GTK_TREE_VIEW (list_view));
+  /* apply rows which are not shown yet */
+  if (update_pending)
+    update_view (NULL);
+
+  model = list_store;
 
   if (options.list_data.print_all)
     {
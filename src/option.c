@@ -54,6 +54,7 @@ static gboolean set_complete_type (const gchar *, const gchar *, gpointer, GErro
 static gboolean set_bool_fmt_type (const gchar *, const gchar *, gpointer, GError **);
 static gboolean set_grid_lines (const gchar *, const gchar *, gpointer, GError **);
 static gboolean set_scroll_policy (const gchar *, const gchar *, gpointer, GError **);
+static gboolean set_page_size (const gchar *, const gchar *, gpointer, GError **);
 #if GLIB_CHECK_VERSION(2,30,0)
 static gboolean set_size_format (const gchar *, const gchar *, gpointer, GError **);
 #endif
@@ -211,6 +212,8 @@ static GOptionEntry common_options[] = {
     N_("Enable preview"), NULL },
   { "large-preview", 0, 0, G_OPTION_ARG_NONE, &options.common_data.large_preview,
     N_("Use large preview"), NULL },
+  { "prefetch-preview", 0, 0, G_OPTION_ARG_NONE, &options.common_data.prefetch_preview,
+    N_("Create thumbnails for images in current folder in background"), NULL },
   { "show-hidden", 0, 0, G_OPTION_ARG_NONE, &options.common_data.show_hidden,
     N_("Show hidden files in file selection dialogs"), NULL },
   { "filename", 0, 0, G_OPTION_ARG_FILENAME, &options.common_data.uri,
@@ -347,6 +350,8 @@ static GOptionEntry form_options[] = {
     N_("Set focused field"), N_("NUMBER") },
   { "cycle-read", 0, 0, G_OPTION_ARG_NONE, &options.form_data.cycle_read,
     N_("Cycled reading of stdin data"), NULL },
+  { "keyed-read", 0, 0, G_OPTION_ARG_NONE, &options.form_data.keyed_read,
+    N_("Read stdin data as N=VALUE or @ID=VALUE lines"), NULL },
   { "align-buttons", 0, 0, G_OPTION_ARG_NONE, &options.form_data.align_buttons,
     N_("Align labels on button fields"), NULL },
   { "changed-action", 0, 0, G_OPTION_ARG_STRING, &options.form_data.changed_action,
@@ -458,16 +463,30 @@ static GOptionEntry list_options[] = {
     N_("Set the row separator value"), N_("TEXT") },
   { "limit", 0, 0, G_OPTION_ARG_INT, &options.list_data.limit,
     N_("Set the limit of rows in list"), N_("NUMBER") },
+  { "key-column", 0, 0, G_OPTION_ARG_INT, &options.list_data.key_column,
+    N_("Set the key column for updating rows from stdin"), N_("NUMBER") },
+  { "snapshot", 0, 0, G_OPTION_ARG_NONE, &options.list_data.snapshot,
+    N_("Update list by diffing snapshots from stdin"), NULL },
   { "dclick-action", 0, 0, G_OPTION_ARG_STRING, &options.list_data.dclick_action,
     N_("Set double-click action"), N_("CMD") },
   { "select-action", 0, 0, G_OPTION_ARG_STRING, &options.list_data.select_action,
     N_("Set select action"), N_("CMD") },
   { "row-action", 0, 0, G_OPTION_ARG_STRING, &options.list_data.row_action,
     N_("Set row action"), N_("CMD") },
+  { "expand-cmd", 0, 0, G_OPTION_ARG_STRING, &options.list_data.expand_cmd,
+    N_("Set command for loading children of tree node"), N_("CMD") },
+  { "page-cmd", 0, 0, G_OPTION_ARG_STRING, &options.list_data.page_cmd,
+    N_("Set command for loading list data by pages"), N_("CMD") },
+  { "page-size", 0, 0, G_OPTION_ARG_CALLBACK, set_page_size,
+    N_("Set the number of rows in page"), N_("NUMBER") },
+  { "max-pages", 0, 0, G_OPTION_ARG_INT, &options.list_data.max_pages,
+    N_("Set the maximum number of loaded pages"), N_("NUMBER") },
   { "tree-expanded", 0, 0, G_OPTION_ARG_NONE, &options.list_data.tree_expanded,
     N_("Expand all tree nodes"), NULL },
   { "regex-search", 0, 0, G_OPTION_ARG_NONE, &options.list_data.regex_search,
     N_("Use regex in search"), NULL },
+  { "filter-bar", 0, 0, G_OPTION_ARG_NONE, &options.list_data.filter_bar,
+    N_("Show entry for filtering list rows"), NULL },
   { "no-selection", 0, 0, G_OPTION_ARG_NONE, &options.list_data.no_selection,
     N_("Disable selection"), NULL },
   { "add-on-top", 0, 0, G_OPTION_ARG_NONE, &options.list_data.add_on_top,
@@ -528,6 +547,12 @@ static GOptionEntry picture_options[] = {
     N_("Set initial size (fit or orig)"), N_("TYPE") },
   { "inc", 0, 0, G_OPTION_ARG_INT, &options.picture_data.inc,
     N_("Set increment for picture scaling (default - 5)"), N_("NUMBER") },
+  { "slideshow", 0, 0, G_OPTION_ARG_NONE, &options.picture_data.slideshow,
+    N_("Show pictures from stdin or command line one by one"), NULL },
+  { "interval", 0, 0, G_OPTION_ARG_INT, &options.picture_data.interval,
+    N_("Set interval between slides in seconds (default - 5)"), N_("SECONDS") },
+  { "preload", 0, 0, G_OPTION_ARG_INT, &options.picture_data.preload,
+    N_("Set number of slides decoded ahead (default - 2)"), N_("NUMBER") },
   { NULL }
 };
 
@@ -1293,6 +1318,20 @@ set_scroll_policy (const gchar * option_name, const gchar * value, gpointer data
   return TRUE;
 }
 
+static gboolean
+set_page_size (const gchar * option_name, const gchar * value, gpointer data, GError ** err)
+{
+  glong size = atol (value);
+
+  /* empty pages never end the list */
+  if (size > 0)
+    options.list_data.page_size = size;
+  else
+    g_printerr (_("Wrong page size: %s\n"), value);
+
+  return TRUE;
+}
+
 #if GLIB_CHECK_VERSION(2,30,0)
 static gboolean
 set_size_format (const gchar * option_name, const gchar * value, gpointer data, GError ** err)
@@ -1571,6 +1610,7 @@ yad_options_init (void)
   options.common_data.listen = FALSE;
   options.common_data.preview = FALSE;
   options.common_data.large_preview = settings.large_preview;
+  options.common_data.prefetch_preview = FALSE;
   options.common_data.show_hidden = FALSE;
   options.common_data.quoted_output = FALSE;
   options.common_data.num_output = FALSE;
@@ -1639,6 +1679,7 @@ yad_options_init (void)
   options.form_data.output_by_row = FALSE;
   options.form_data.focus_field = 1;
   options.form_data.cycle_read = FALSE;
+  options.form_data.keyed_read = FALSE;
   options.form_data.align_buttons = FALSE;
   options.form_data.changed_action = NULL;
   options.form_data.homogeneous = FALSE;
@@ -1687,6 +1728,8 @@ yad_options_init (void)
   options.list_data.sep_column = 0;
   options.list_data.sep_value = NULL;
   options.list_data.limit = 0;
+  options.list_data.key_column = 0;
+  options.list_data.snapshot = FALSE;
   options.list_data.editable_cols = NULL;
   options.list_data.wrap_width = 0;
   options.list_data.wrap_cols = NULL;
@@ -1695,8 +1738,13 @@ yad_options_init (void)
   options.list_data.dclick_action = NULL;
   options.list_data.select_action = NULL;
   options.list_data.row_action = NULL;
+  options.list_data.expand_cmd = NULL;
+  options.list_data.page_cmd = NULL;
+  options.list_data.page_size = 100;
+  options.list_data.max_pages = 0;
   options.list_data.tree_expanded = FALSE;
   options.list_data.regex_search = FALSE;
+  options.list_data.filter_bar = FALSE;
   options.list_data.clickable = TRUE;
   options.list_data.no_selection = FALSE;
   options.list_data.add_on_top = FALSE;
@@ -1724,6 +1772,9 @@ yad_options_init (void)
   /* Initialize picture data */
   options.picture_data.size = YAD_PICTURE_ORIG;
   options.picture_data.inc = 5;
+  options.picture_data.slideshow = FALSE;
+  options.picture_data.interval = 5;
+  options.picture_data.preload = 2;
 
   /* Initialize print data */
   options.print_data.type = YAD_PRINT_TEXT;
@@ -17,8 +17,55 @@
  * Copyright (C) 2008-2019, Victor Ananjevsky <ananasik@gmail.com>
  */
 
+#include <math.h>
+
 #include "yad.h"
 
+/* size of chunks for picture loader */
+#define LOAD_CHUNK_SIZE 65536
+/* interval between progress updates (in microseconds) */
+#define PROGRESS_INTERVAL 250000
+/* max size of progress preview */
+#define PROGRESS_SIZE 512
+/* max number of screens which decoded image may cover */
+#define MAX_SCREENS 4
+/* max size of image decoded for original size (in pixels) */
+#define MAX_FULL_PIXELS (64 * 1024 * 1024)
+/* max number of scaling levels */
+#define MAX_LEVELS 8
+/* min size of scaling level */
+#define MIN_LEVEL_SIZE 32
+/* delay before high quality rendering (in milliseconds) */
+#define HQ_DELAY 200
+/* max memory for preloaded slides */
+#define PRELOAD_MEMORY (256 * 1024 * 1024)
+
+typedef struct {
+  gchar *filename;
+  gint index;                   /* number of slide */
+  gdouble max_pixels;
+  gboolean reduced;             /* image was decoded with lower resolution */
+  GCancellable *cancel;
+  gint rows;                    /* number of decoded rows */
+  GdkPixbuf *pb;                /* progress preview */
+  GdkPixbufAnimation *anim;
+} LoadData;
+
+typedef struct {
+  guint serial;
+  GdkPixbuf *levels[MAX_LEVELS];
+  gint n_levels;
+} MipmapData;
+
+typedef struct {
+  guint serial;
+  GdkPixbuf *src;
+  gint width, height;
+  gint rotation;
+  gboolean flip;
+  GdkPixbuf *pb;
+} RenderData;
+
 static GtkWidget *picture;
 static GtkWidget *viewport;
 static GtkWidget *popup_menu;
@@ -29,6 +76,35 @@ static GdkPixbuf *orig_pb;
 static gboolean loaded = FALSE;
 static gboolean animated = FALSE;
 
+/* scaling levels of current image. first one is the image itself */
+static GdkPixbuf *levels[MAX_LEVELS];
+static gint n_levels = 0;
+static guint image_serial = 0;
+
+static gdouble scale = 1.0;
+static gint rotation = 0;       /* number of clockwise quarter turns */
+static gboolean flip = FALSE;   /* horizontal flip before rotation */
+static gboolean fit_mode = FALSE;
+
+static guint render_serial = 0;
+static guint hq_timer = 0;
+static guint fit_idle = 0;
+
+static GCancellable *load_cancel = NULL;
+
+/* slideshow data */
+static GPtrArray *slides = NULL;
+static gint cur_slide = -1;
+static gint wait_slide = -1;
+static GHashTable *preloaded = NULL;    /* slide number -> animation */
+static GHashTable *preloading = NULL;   /* slide number -> cancellable */
+static gsize preload_size = 0;
+static GdkPixbufAnimation *spare_anim = NULL;  /* preloaded slide which exceeds memory limit */
+static gint spare_slide = -1;
+static GThreadPool *preload_pool = NULL;
+static guint slide_timer = 0;
+static gboolean paused = FALSE;
+
 enum {
   SIZE_FIT,
   SIZE_ORIG,
@@ -43,133 +119,912 @@ enum {
   ROTATE_FLIP_HOR
 };
 
+static GdkPixbuf *
+scale_pixbuf (GdkPixbuf *pb, gint width, gint height, GdkInterpType interp)
+{
+  if (gdk_pixbuf_get_width (pb) == width && gdk_pixbuf_get_height (pb) == height)
+    return g_object_ref (pb);
+  return gdk_pixbuf_scale_simple (pb, width, height, interp);
+}
+
+/* flip (if needed) and rotate clockwise by rot quarters */
+static GdkPixbuf *
+transform_pixbuf (GdkPixbuf *pb, gint rot, gboolean hflip)
+{
+  GdkPixbuf *res, *tmp;
+
+  res = g_object_ref (pb);
+  if (hflip)
+    {
+      tmp = gdk_pixbuf_flip (res, TRUE);
+      g_object_unref (res);
+      res = tmp;
+    }
+  if (rot)
+    {
+      tmp = gdk_pixbuf_rotate_simple (res, (GdkPixbufRotation) (((4 - rot) % 4) * 90));
+      g_object_unref (res);
+      res = tmp;
+    }
+
+  return res;
+}
+
+static gboolean
+mipmap_done (MipmapData *md)
+{
+  gint i;
+
+  if (md->serial == image_serial)
+    {
+      /* replace levels with new ones */
+      for (i = 0; i < n_levels; i++)
+        g_object_unref (levels[i]);
+      for (i = 0; i < md->n_levels; i++)
+        levels[i] = md->levels[i];
+      n_levels = md->n_levels;
+    }
+  else
+    {
+      for (i = 0; i < md->n_levels; i++)
+        g_object_unref (md->levels[i]);
+    }
+  g_free (md);
+
+  return FALSE;
+}
+
+static gpointer
+mipmap_thread (MipmapData *md)
+{
+  /* each level is a half of previous one */
+  while (md->n_levels < MAX_LEVELS)
+    {
+      GdkPixbuf *prev = md->levels[md->n_levels - 1];
+      gint width = gdk_pixbuf_get_width (prev) / 2;
+      gint height = gdk_pixbuf_get_height (prev) / 2;
+
+      if (width < MIN_LEVEL_SIZE || height < MIN_LEVEL_SIZE)
+        break;
+      md->levels[md->n_levels++] = gdk_pixbuf_scale_simple (prev, width, height, GDK_INTERP_BILINEAR);
+    }
+
+  g_idle_add ((GSourceFunc) mipmap_done, md);
+
+  return NULL;
+}
+
+/* make levels of scaling for current image */
 static void
-load_picture (gchar *filename)
+create_levels ()
+{
+  MipmapData *md;
+  gint i;
+
+  for (i = 0; i < n_levels; i++)
+    g_object_unref (levels[i]);
+  levels[0] = g_object_ref (orig_pb);
+  n_levels = 1;
+
+  md = g_new0 (MipmapData, 1);
+  md->serial = image_serial;
+  md->levels[0] = g_object_ref (orig_pb);
+  md->n_levels = 1;
+
+  g_thread_unref (g_thread_new ("mipmap", (GThreadFunc) mipmap_thread, md));
+}
+
+/* get smallest level which is not less than needed size */
+static GdkPixbuf *
+get_level (gint width, gint height)
+{
+  gint i;
+
+  for (i = 0; i + 1 < n_levels; i++)
+    {
+      if (gdk_pixbuf_get_width (levels[i + 1]) < width || gdk_pixbuf_get_height (levels[i + 1]) < height)
+        break;
+    }
+
+  return levels[i];
+}
+
+static gboolean
+render_done (RenderData *rd)
+{
+  /* image was changed while rendering */
+  if (rd->serial == render_serial)
+    gtk_image_set_from_pixbuf (GTK_IMAGE (picture), rd->pb);
+
+  g_object_unref (rd->src);
+  g_object_unref (rd->pb);
+  g_free (rd);
+
+  return FALSE;
+}
+
+static gpointer
+render_thread (RenderData *rd)
+{
+  GdkPixbuf *pb;
+
+  pb = scale_pixbuf (rd->src, rd->width, rd->height, GDK_INTERP_HYPER);
+  rd->pb = transform_pixbuf (pb, rd->rotation, rd->flip);
+  g_object_unref (pb);
+
+  g_idle_add ((GSourceFunc) render_done, rd);
+
+  return NULL;
+}
+
+static gboolean
+hq_timeout_cb (gpointer data)
+{
+  RenderData *rd;
+
+  hq_timer = 0;
+
+  rd = g_new0 (RenderData, 1);
+  rd->serial = render_serial;
+  rd->width = MAX (gdk_pixbuf_get_width (orig_pb) * scale, 1);
+  rd->height = MAX (gdk_pixbuf_get_height (orig_pb) * scale, 1);
+  rd->src = g_object_ref (get_level (rd->width, rd->height));
+  rd->rotation = rotation;
+  rd->flip = flip;
+
+  g_thread_unref (g_thread_new ("render", (GThreadFunc) render_thread, rd));
+
+  return FALSE;
+}
+
+/* show image with current scale and rotation. makes fast low quality image first */
+static void
+render_picture ()
 {
-  anim_pb = gdk_pixbuf_animation_new_from_file (filename, NULL);
-  orig_pb = gdk_pixbuf_animation_get_static_image (anim_pb);
+  GdkPixbuf *src, *pb, *tmp;
+  gint width, height;
+
+  width = MAX (gdk_pixbuf_get_width (orig_pb) * scale, 1);
+  height = MAX (gdk_pixbuf_get_height (orig_pb) * scale, 1);
+  src = get_level (width, height);
+
+  render_serial++;
+  if (hq_timer)
+    {
+      g_source_remove (hq_timer);
+      hq_timer = 0;
+    }
+
+  tmp = scale_pixbuf (src, width, height, GDK_INTERP_NEAREST);
+  pb = transform_pixbuf (tmp, rotation, flip);
+  g_object_unref (tmp);
+  gtk_image_set_from_pixbuf (GTK_IMAGE (picture), pb);
+  g_object_unref (pb);
+
+  if (gdk_pixbuf_get_width (src) != width || gdk_pixbuf_get_height (src) != height)
+    hq_timer = g_timeout_add (HQ_DELAY, (GSourceFunc) hq_timeout_cb, NULL);
+}
+
+static void
+free_load_data (LoadData *ld)
+{
+  g_free (ld->filename);
+  g_object_unref (ld->cancel);
+  if (ld->pb)
+    g_object_unref (ld->pb);
+  if (ld->anim)
+    g_object_unref (ld->anim);
+  g_free (ld);
+}
+
+/* limit size of decoded image. huge images are decoded with lower resolution */
+static void
+size_prepared_cb (GdkPixbufLoader *loader, gint width, gint height, LoadData *ld)
+{
+  gdouble factor;
+
+  factor = sqrt (ld->max_pixels / ((gdouble) width * height));
+  if (factor < 1.0)
+    {
+      gdk_pixbuf_loader_set_size (loader, MAX (width * factor, 1), MAX (height * factor, 1));
+      ld->reduced = TRUE;
+    }
+}
+
+static void
+area_updated_cb (GdkPixbufLoader *loader, gint x, gint y, gint width, gint height, LoadData *ld)
+{
+  ld->rows = MAX (ld->rows, y + height);
+}
+
+static gboolean
+load_progress (LoadData *ld)
+{
+  if (!g_cancellable_is_cancelled (ld->cancel) && !loaded)
+    gtk_image_set_from_pixbuf (GTK_IMAGE (picture), ld->pb);
+
+  g_object_unref (ld->cancel);
+  g_object_unref (ld->pb);
+  g_free (ld);
+
+  return FALSE;
+}
+
+/* make low-res copy of decoded part of image */
+static void
+send_progress (GdkPixbufLoader *loader, LoadData *ld)
+{
+  LoadData *pd;
+  GdkPixbuf *pb, *prev;
+  gint width, height;
+  gdouble factor;
+
+  pb = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (!pb || ld->rows == 0)
+    return;
+
+  width = gdk_pixbuf_get_width (pb);
+  height = gdk_pixbuf_get_height (pb);
+  factor = MIN (1.0, MIN ((gdouble) PROGRESS_SIZE / width, (gdouble) PROGRESS_SIZE / height));
+
+  prev = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, MAX (width * factor, 1), MAX (height * factor, 1));
+  gdk_pixbuf_fill (prev, 0);
+  gdk_pixbuf_scale (pb, prev, 0, 0, gdk_pixbuf_get_width (prev), MAX (ld->rows * factor, 1),
+                    0, 0, factor, factor, GDK_INTERP_NEAREST);
+
+  pd = g_new0 (LoadData, 1);
+  pd->cancel = g_object_ref (ld->cancel);
+  pd->pb = prev;
+  g_idle_add ((GSourceFunc) load_progress, pd);
+}
+
+static GdkPixbufAnimation *
+decode_picture (LoadData *ld, gboolean progress)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbufAnimation *anim = NULL;
+  GFile *file;
+  GFileInputStream *in;
+  guchar *buf;
+  gssize len;
+  gint64 last = 0;
+  gboolean ok = TRUE;
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (G_OBJECT (loader), "size-prepared", G_CALLBACK (size_prepared_cb), ld);
+  g_signal_connect (G_OBJECT (loader), "area-updated", G_CALLBACK (area_updated_cb), ld);
+
+  file = g_file_new_for_path (ld->filename);
+  in = g_file_read (file, ld->cancel, NULL);
+  g_object_unref (file);
+
+  if (in)
+    {
+      /* feed loader by chunks, so image can be shown while loading */
+      buf = g_malloc (LOAD_CHUNK_SIZE);
+      while ((len = g_input_stream_read (G_INPUT_STREAM (in), buf, LOAD_CHUNK_SIZE, ld->cancel, NULL)) > 0)
+        {
+          gint64 now;
+
+          if (!gdk_pixbuf_loader_write (loader, buf, len, NULL))
+            {
+              ok = FALSE;
+              break;
+            }
+
+          if (progress)
+            {
+              now = g_get_monotonic_time ();
+              if (now - last > PROGRESS_INTERVAL)
+                {
+                  if (last)
+                    send_progress (loader, ld);
+                  last = now;
+                }
+            }
+        }
+      if (len < 0)
+        ok = FALSE;
+      g_free (buf);
+      g_object_unref (in);
+    }
+  else
+    ok = FALSE;
+
+  if (gdk_pixbuf_loader_close (loader, NULL) && ok)
+    {
+      anim = gdk_pixbuf_loader_get_animation (loader);
+      if (anim)
+        {
+          g_object_ref (anim);
+          /* remember file for decoding in full resolution on demand */
+          if (ld->reduced)
+            g_object_set_data_full (G_OBJECT (anim), "full_file", g_strdup (ld->filename), g_free);
+        }
+    }
+  g_object_unref (loader);
+
+  return anim;
+}
+
+/* show new image. takes ownership of anim */
+static void
+set_picture (GdkPixbufAnimation *anim)
+{
+  if (anim_pb)
+    g_object_unref (anim_pb);
+  anim_pb = anim;
+  orig_pb = anim ? gdk_pixbuf_animation_get_static_image (anim) : NULL;
+
+  loaded = animated = FALSE;
+  image_serial++;
+  render_serial++;
+  if (hq_timer)
+    {
+      g_source_remove (hq_timer);
+      hq_timer = 0;
+    }
+
+  scale = 1.0;
+  rotation = 0;
+  flip = FALSE;
 
   if (orig_pb)
     {
       if (gdk_pixbuf_animation_is_static_image (anim_pb))
-        gtk_image_set_from_pixbuf (GTK_IMAGE (picture), orig_pb);
+        {
+          create_levels ();
+          loaded = TRUE;
+          render_picture ();
+          if (fit_mode)
+            picture_fit_to_window ();
+        }
       else
         {
           gtk_image_set_from_animation (GTK_IMAGE (picture), anim_pb);
           animated = TRUE;
+          loaded = TRUE;
         }
-      loaded = TRUE;
     }
   else
     gtk_image_set_from_icon_name (GTK_IMAGE (picture), "image-missing", GTK_ICON_SIZE_DIALOG);
 }
 
+static gboolean
+load_done (LoadData *ld)
+{
+  if (!g_cancellable_is_cancelled (ld->cancel))
+    {
+      set_picture (ld->anim);
+      ld->anim = NULL;
+    }
+  free_load_data (ld);
+
+  return FALSE;
+}
+
+static gpointer
+load_thread (LoadData *ld)
+{
+  ld->anim = decode_picture (ld, TRUE);
+  g_idle_add ((GSourceFunc) load_done, ld);
+
+  return NULL;
+}
+
+static gdouble
+get_max_pixels ()
+{
+  gint sw, sh;
+
+#if !GTK_CHECK_VERSION(3,0,0)
+  gdk_window_get_geometry (gdk_get_default_root_window (), NULL, NULL, &sw, &sh, NULL);
+#else
+  gdk_window_get_geometry (gdk_get_default_root_window (), NULL, NULL, &sw, &sh);
+#endif
+
+  return (gdouble) MAX_SCREENS * sw * sh;
+}
+
+static void
+stop_loading ()
+{
+  if (load_cancel)
+    {
+      g_cancellable_cancel (load_cancel);
+      g_object_unref (load_cancel);
+      load_cancel = NULL;
+    }
+}
+
+static void
+load_picture (gchar *filename)
+{
+  LoadData *ld;
+
+  stop_loading ();
+
+  ld = g_new0 (LoadData, 1);
+  ld->filename = g_strdup (filename);
+  ld->max_pixels = get_max_pixels ();
+  ld->cancel = g_cancellable_new ();
+  load_cancel = g_object_ref (ld->cancel);
+
+  gtk_image_set_from_icon_name (GTK_IMAGE (picture), "image-loading", GTK_ICON_SIZE_DIALOG);
+
+  /* decode image in background */
+  g_thread_unref (g_thread_new ("load_picture", (GThreadFunc) load_thread, ld));
+}
+
+static gboolean
+load_full_done (LoadData *ld)
+{
+  gint rot;
+  gboolean hflip;
+
+  if (!g_cancellable_is_cancelled (ld->cancel) && ld->anim)
+    {
+      if (ld->reduced)
+        {
+          g_printerr (_("picture: image is too big, shown with reduced resolution\n"));
+          g_object_set_data (G_OBJECT (ld->anim), "full_file", NULL);
+        }
+
+      /* keep orientation of the image */
+      rot = rotation;
+      hflip = flip;
+      fit_mode = FALSE;
+      set_picture (ld->anim);
+      ld->anim = NULL;
+      rotation = rot;
+      flip = hflip;
+      if (loaded && !animated)
+        render_picture ();
+    }
+  free_load_data (ld);
+
+  return FALSE;
+}
+
+static gpointer
+load_full_thread (LoadData *ld)
+{
+  ld->anim = decode_picture (ld, FALSE);
+  g_idle_add ((GSourceFunc) load_full_done, ld);
+
+  return NULL;
+}
+
+/* decode current image again with hard size limit. current image is shown until done */
+static void
+load_full_picture (gchar *filename)
+{
+  LoadData *ld;
+
+  stop_loading ();
+
+  ld = g_new0 (LoadData, 1);
+  ld->filename = g_strdup (filename);
+  ld->max_pixels = MAX (MAX_FULL_PIXELS, get_max_pixels ());
+  ld->cancel = g_cancellable_new ();
+  load_cancel = g_object_ref (ld->cancel);
+
+  g_thread_unref (g_thread_new ("load_full", (GThreadFunc) load_full_thread, ld));
+}
+
+static void show_slide (gint n);
+
+static gsize
+anim_size (GdkPixbufAnimation *anim)
+{
+  GdkPixbuf *pb = gdk_pixbuf_animation_get_static_image (anim);
+
+  return pb ? (gsize) gdk_pixbuf_get_rowstride (pb) * gdk_pixbuf_get_height (pb) : 0;
+}
+
+static void
+drop_spare ()
+{
+  if (spare_anim)
+    g_object_unref (spare_anim);
+  spare_anim = NULL;
+  spare_slide = -1;
+}
+
+static gboolean
+preload_done (LoadData *ld)
+{
+  if (!g_cancellable_is_cancelled (ld->cancel))
+    {
+      g_hash_table_remove (preloading, GINT_TO_POINTER (ld->index));
+
+      if (ld->anim && preload_size + anim_size (ld->anim) <= PRELOAD_MEMORY)
+        {
+          preload_size += anim_size (ld->anim);
+          g_hash_table_insert (preloaded, GINT_TO_POINTER (ld->index), ld->anim);
+          ld->anim = NULL;
+        }
+      else if (ld->anim)
+        {
+          /* keep one image which exceeds memory limit, so it isn't decoded twice */
+          drop_spare ();
+          spare_anim = ld->anim;
+          spare_slide = ld->index;
+          ld->anim = NULL;
+        }
+
+      if (ld->index == wait_slide)
+        show_slide (ld->index);
+    }
+  free_load_data (ld);
+
+  return FALSE;
+}
+
+static void
+preload_thread (LoadData *ld, gpointer data)
+{
+  if (!g_cancellable_is_cancelled (ld->cancel))
+    ld->anim = decode_picture (ld, FALSE);
+  g_idle_add ((GSourceFunc) preload_done, ld);
+}
+
+/* check if slide i must be kept when slide n is shown */
+static gboolean
+in_window (gint i, gint n)
+{
+  gint len = slides->len;
+  gint d = (i - n + len) % len;
+
+  return d <= options.picture_data.preload || d == len - 1;
+}
+
+/* decode next slides ahead and drop the far ones */
+static void
+update_preload (gint n)
+{
+  GHashTableIter it;
+  gpointer key, val;
+  gint k;
+
+  g_hash_table_iter_init (&it, preloaded);
+  while (g_hash_table_iter_next (&it, &key, &val))
+    {
+      if (!in_window (GPOINTER_TO_INT (key), n))
+        {
+          preload_size -= anim_size (GDK_PIXBUF_ANIMATION (val));
+          g_hash_table_iter_remove (&it);
+        }
+    }
+
+  g_hash_table_iter_init (&it, preloading);
+  while (g_hash_table_iter_next (&it, &key, &val))
+    {
+      if (!in_window (GPOINTER_TO_INT (key), n))
+        {
+          g_cancellable_cancel (G_CANCELLABLE (val));
+          g_hash_table_iter_remove (&it);
+        }
+    }
+
+  if (spare_slide >= 0 && !in_window (spare_slide, n))
+    drop_spare ();
+
+  for (k = 1; k <= options.picture_data.preload && k < (gint) slides->len; k++)
+    {
+      LoadData *ld;
+      gint i = (n + k) % slides->len;
+
+      if (i == spare_slide || g_hash_table_contains (preloaded, GINT_TO_POINTER (i)) ||
+          g_hash_table_contains (preloading, GINT_TO_POINTER (i)))
+        continue;
+
+      ld = g_new0 (LoadData, 1);
+      ld->filename = g_strdup (g_ptr_array_index (slides, i));
+      ld->index = i;
+      ld->max_pixels = get_max_pixels ();
+      ld->cancel = g_cancellable_new ();
+
+      g_hash_table_insert (preloading, GINT_TO_POINTER (i), ld->cancel);
+      g_thread_pool_push (preload_pool, ld, NULL);
+    }
+}
+
+static gboolean
+slide_timeout_cb (gpointer data)
+{
+  gint next;
+
+  slide_timer = 0;
+
+  if (slides->len < 2)
+    return FALSE;
+
+  next = (cur_slide + 1) % slides->len;
+  /* don't break current slide while next one is decoding */
+  if (g_hash_table_contains (preloading, GINT_TO_POINTER (next)))
+    wait_slide = next;
+  else
+    show_slide (next);
+
+  return FALSE;
+}
+
+static void
+start_slide_timer ()
+{
+  if (slide_timer)
+    {
+      g_source_remove (slide_timer);
+      slide_timer = 0;
+    }
+
+  if (!paused && options.picture_data.interval > 0 && slides->len > 1)
+    slide_timer = g_timeout_add_seconds (options.picture_data.interval, slide_timeout_cb, NULL);
+}
+
+static void
+show_slide (gint n)
+{
+  GdkPixbufAnimation *anim;
+
+  if (slides->len == 0)
+    return;
+
+  n = (n + slides->len) % slides->len;
+  cur_slide = n;
+  wait_slide = -1;
+  /* zooming of previous slide doesn't stay */
+  fit_mode = (options.picture_data.size == YAD_PICTURE_FIT);
+
+  anim = (GdkPixbufAnimation *) g_hash_table_lookup (preloaded, GINT_TO_POINTER (n));
+  if (!anim && n == spare_slide)
+    anim = spare_anim;
+  if (anim)
+    {
+      stop_loading ();
+      set_picture (g_object_ref (anim));
+      if (n == spare_slide)
+        drop_spare ();
+    }
+  else if (g_hash_table_contains (preloading, GINT_TO_POINTER (n)))
+    wait_slide = n;
+  else
+    load_picture (g_ptr_array_index (slides, n));
+
+  update_preload (n);
+  start_slide_timer ();
+}
+
+static void
+add_slide (gchar *str)
+{
+  gchar *filename;
+
+  if (g_str_has_prefix (str, "file://"))
+    filename = g_filename_from_uri (str, NULL, NULL);
+  else
+    filename = g_strdup (str);
+  if (!filename)
+    return;
+
+  g_ptr_array_add (slides, filename);
+
+  if (cur_slide < 0)
+    show_slide (0);
+  else
+    {
+      update_preload (cur_slide);
+      if (!slide_timer)
+        start_slide_timer ();
+    }
+}
+
+static void
+clear_slides ()
+{
+  GHashTableIter it;
+  gpointer val;
+
+  g_hash_table_iter_init (&it, preloading);
+  while (g_hash_table_iter_next (&it, NULL, &val))
+    g_cancellable_cancel (G_CANCELLABLE (val));
+  g_hash_table_remove_all (preloading);
+
+  g_hash_table_remove_all (preloaded);
+  preload_size = 0;
+
+  g_ptr_array_set_size (slides, 0);
+  cur_slide = wait_slide = -1;
+
+  if (slide_timer)
+    {
+      g_source_remove (slide_timer);
+      slide_timer = 0;
+    }
+}
+
+static gboolean
+handle_stdin (GIOChannel * ch, GIOCondition cond, gpointer data)
+{
+  if ((cond == G_IO_IN) || (cond == G_IO_IN + G_IO_HUP))
+    {
+      GError *err = NULL;
+      GString *string = g_string_new (NULL);
+
+      while (ch->is_readable != TRUE);
+
+      do
+        {
+          gint status;
+
+          do
+            {
+              status = g_io_channel_read_line_string (ch, string, NULL, &err);
+
+              while (gtk_events_pending ())
+                gtk_main_iteration ();
+            }
+          while (status == G_IO_STATUS_AGAIN);
+
+          if (status != G_IO_STATUS_NORMAL)
+            {
+              if (err)
+                {
+                  g_printerr ("yad_picture_handle_stdin(): %s\n", err->message);
+                  g_error_free (err);
+                  err = NULL;
+                }
+              /* stop handling */
+              g_io_channel_shutdown (ch, TRUE, NULL);
+              g_string_free (string, TRUE);
+              return FALSE;
+            }
+
+          strip_new_line (string->str);
+          /* clear slides list if ^L received */
+          if (string->str[0] == '\014')
+            clear_slides ();
+          else if (string->str[0])
+            add_slide (string->str);
+        }
+      while (g_io_channel_get_buffer_condition (ch) == G_IO_IN);
+      g_string_free (string, TRUE);
+    }
+
+  if ((cond != G_IO_IN) && (cond != G_IO_IN + G_IO_HUP))
+    {
+      g_io_channel_shutdown (ch, TRUE, NULL);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 void
 picture_fit_to_window ()
 {
   gdouble width, height, ww, wh;
-  gdouble factor;
 
-  if (animated)
+  /* image is not loaded yet or window is not shown */
+  if (!loaded || animated || !gtk_widget_get_realized (viewport))
     return;
 
-  width = gdk_pixbuf_get_width (orig_pb);
-  height = gdk_pixbuf_get_height (orig_pb);
+  if (rotation % 2)
+    {
+      width = gdk_pixbuf_get_height (orig_pb);
+      height = gdk_pixbuf_get_width (orig_pb);
+    }
+  else
+    {
+      width = gdk_pixbuf_get_width (orig_pb);
+      height = gdk_pixbuf_get_height (orig_pb);
+    }
 
   ww = gdk_window_get_width (gtk_viewport_get_view_window (GTK_VIEWPORT (viewport)));
   wh = gdk_window_get_height (gtk_viewport_get_view_window (GTK_VIEWPORT (viewport)));
 
-  factor = MIN (ww / width, wh / height);
-  if (factor < 1.0)
-    {
-      GdkPixbuf *pb = gdk_pixbuf_scale_simple (g_object_ref (orig_pb), width * factor, height * factor, GDK_INTERP_HYPER);
-      if (pb)
-        {
-          GdkPixbuf *old_pb = gtk_image_get_pixbuf (GTK_IMAGE (picture));
-          gtk_image_set_from_pixbuf (GTK_IMAGE (picture), pb);
-          g_object_unref (old_pb);
-        }
-    }
+  /* small images are not enlarged */
+  scale = MIN (1.0, MIN (ww / width, wh / height));
+  fit_mode = TRUE;
+
+  render_picture ();
+}
+
+static gboolean
+fit_idle_cb (gpointer data)
+{
+  fit_idle = 0;
+  if (fit_mode)
+    picture_fit_to_window ();
+  return FALSE;
+}
+
+static void
+size_allocate_cb (GtkWidget *w, GtkAllocation *al, gpointer data)
+{
+  static gint width = 0, height = 0;
+
+  /* refit image after window resizing */
+  if (fit_mode && !fit_idle && (al->width != width || al->height != height))
+    fit_idle = g_idle_add (fit_idle_cb, NULL);
+
+  width = al->width;
+  height = al->height;
 }
 
 static void
 change_size_cb (GtkWidget *w, gint type)
 {
-  gdouble width, height;
-  GdkPixbuf *new_pb, *pb = gtk_image_get_pixbuf (GTK_IMAGE (picture));
+  gdouble width;
 
-  if (!pb)
+  if (!loaded || animated)
     {
       g_printerr ("picture: can't get pixbuf\n");
       return;
     }
 
-  width = gdk_pixbuf_get_width (pb);
-  height = gdk_pixbuf_get_height (pb);
+  width = gdk_pixbuf_get_width (orig_pb);
 
   switch (type)
     {
     case SIZE_FIT:
       picture_fit_to_window ();
-      break;
+      return;
     case SIZE_ORIG:
-      gtk_image_set_from_pixbuf (GTK_IMAGE (picture), orig_pb);
-      g_object_unref (pb);
-      break;
-    case SIZE_INC:
-      new_pb = gdk_pixbuf_scale_simple (pb, width + options.picture_data.inc,
-                                        height + options.picture_data.inc, GDK_INTERP_HYPER);
-      if (new_pb)
+      scale = 1.0;
+      /* huge image was decoded downsampled, so decode it in full resolution */
+      if (g_object_get_data (G_OBJECT (anim_pb), "full_file"))
         {
-          gtk_image_set_from_pixbuf (GTK_IMAGE (picture), new_pb);
-          g_object_unref (pb);
+          fit_mode = FALSE;
+          load_full_picture (g_object_get_data (G_OBJECT (anim_pb), "full_file"));
+          return;
         }
       break;
+    case SIZE_INC:
+      scale = (width * scale + options.picture_data.inc) / width;
+      break;
     case SIZE_DEC:
-      new_pb = gdk_pixbuf_scale_simple (pb, width - options.picture_data.inc,
-                                        height - options.picture_data.inc, GDK_INTERP_HYPER);
-      if (new_pb)
-        {
-          gtk_image_set_from_pixbuf (GTK_IMAGE (picture), new_pb);
-          g_object_unref (pb);
-        }
+      scale = MAX (width * scale - options.picture_data.inc, 1) / width;
       break;
     }
+
+  fit_mode = FALSE;
+  render_picture ();
 }
 
 static void
 rotate_cb (GtkWidget *w, gint type)
 {
-  GdkPixbuf *new_pb = NULL;
-  GdkPixbuf *pb = gtk_image_get_pixbuf (GTK_IMAGE (picture));
-
-  if (!pb)
+  if (!loaded || animated)
     {
       g_printerr ("picture: can't get pixbuf\n");
       return;
     }
 
+  /* transformations are applied to the scaled image, so keep only their sum */
   switch (type)
     {
     case ROTATE_LEFT:
-      new_pb = gdk_pixbuf_rotate_simple (pb, GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE);
+      rotation = (rotation + 3) % 4;
       break;
     case ROTATE_RIGHT:
-      new_pb = gdk_pixbuf_rotate_simple (pb, GDK_PIXBUF_ROTATE_CLOCKWISE);
+      rotation = (rotation + 1) % 4;
       break;
     case ROTATE_FLIP_VERT:
-      new_pb = gdk_pixbuf_flip (pb, FALSE);
+      rotation = (6 - rotation) % 4;
+      flip = !flip;
       break;
     case ROTATE_FLIP_HOR:
-      new_pb = gdk_pixbuf_flip (pb, TRUE);
+      rotation = (4 - rotation) % 4;
+      flip = !flip;
       break;
     }
 
-  if (new_pb)
-    {
-      gtk_image_set_from_pixbuf (GTK_IMAGE (picture), new_pb);
-      g_object_unref (pb);
-    }
+  if (fit_mode)
+    picture_fit_to_window ();
+  else
+    render_picture ();
 }
 
 static void
@@ -228,6 +1083,13 @@ create_popup_menu ()
 static gboolean
 button_handler (GtkWidget *w, GdkEventButton *ev, gpointer data)
 {
+  if (gtk_widget_get_can_focus (w))
+    gtk_widget_grab_focus (w);
+
+  /* actions are available only for static images */
+  if (!loaded || animated)
+    return FALSE;
+
   if (ev->button == 3)
     {
 #if GTK_CHECK_VERSION(3,22,0)
@@ -244,6 +1106,41 @@ button_handler (GtkWidget *w, GdkEventButton *ev, gpointer data)
 static gboolean
 key_handler (GtkWidget *w, GdkEventKey *ev, gpointer data)
 {
+  if (!options.picture_data.slideshow || slides->len == 0)
+    return FALSE;
+
+  /* slideshow navigation */
+  switch (ev->keyval)
+    {
+    case GDK_KEY_Right:
+    case GDK_KEY_Page_Down:
+    case GDK_KEY_space:
+      show_slide (cur_slide + 1);
+      return TRUE;
+    case GDK_KEY_Left:
+    case GDK_KEY_Page_Up:
+    case GDK_KEY_BackSpace:
+      show_slide (cur_slide - 1);
+      return TRUE;
+    case GDK_KEY_Home:
+      show_slide (0);
+      return TRUE;
+    case GDK_KEY_End:
+      show_slide (slides->len - 1);
+      return TRUE;
+    case GDK_KEY_p:
+    case GDK_KEY_Pause:
+      paused = !paused;
+      if (paused && slide_timer)
+        {
+          g_source_remove (slide_timer);
+          slide_timer = 0;
+        }
+      else if (!paused)
+        start_slide_timer ();
+      return TRUE;
+    }
+
   return FALSE;
 }
 
@@ -259,6 +1156,7 @@ picture_create_widget (GtkWidget * dlg)
   viewport = gtk_viewport_new (gtk_scrolled_window_get_hadjustment (GTK_SCROLLED_WINDOW (sw)),
                                gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (sw)));
   gtk_container_add (GTK_CONTAINER (sw), viewport);
+  g_signal_connect (G_OBJECT (viewport), "size-allocate", G_CALLBACK (size_allocate_cb), NULL);
 
   ev = gtk_event_box_new ();
   gtk_container_add (GTK_CONTAINER (viewport), ev);
@@ -266,19 +1164,48 @@ picture_create_widget (GtkWidget * dlg)
   picture = gtk_image_new ();
   gtk_container_add (GTK_CONTAINER (ev), picture);
 
+  fit_mode = (options.picture_data.size == YAD_PICTURE_FIT);
+
   /* load picture */
-  if (options.common_data.uri &&
+  if (options.picture_data.slideshow)
+    {
+      slides = g_ptr_array_new_with_free_func (g_free);
+      preloaded = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_object_unref);
+      preloading = g_hash_table_new (g_direct_hash, g_direct_equal);
+      preload_pool = g_thread_pool_new ((GFunc) preload_thread, NULL, 1, FALSE, NULL);
+
+      /* view gets keys for navigation, buttons keep them when focused */
+      gtk_widget_set_can_focus (ev, TRUE);
+      g_signal_connect (G_OBJECT (ev), "map", G_CALLBACK (gtk_widget_grab_focus), NULL);
+
+      if (options.extra_data)
+        {
+          gint i;
+
+          for (i = 0; options.extra_data[i]; i++)
+            add_slide (options.extra_data[i]);
+        }
+      else
+        {
+          GIOChannel *channel;
+
+          gtk_image_set_from_icon_name (GTK_IMAGE (picture), "image-loading", GTK_ICON_SIZE_DIALOG);
+
+          channel = g_io_channel_unix_new (0);
+          g_io_channel_set_encoding (channel, NULL, NULL);
+          g_io_channel_set_flags (channel, G_IO_FLAG_NONBLOCK, NULL);
+          g_io_add_watch (channel, G_IO_IN | G_IO_HUP, handle_stdin, NULL);
+        }
+    }
+  else if (options.common_data.uri &&
       g_file_test (options.common_data.uri, G_FILE_TEST_EXISTS))
     load_picture (options.common_data.uri);
   else
     gtk_image_set_from_icon_name (GTK_IMAGE (picture), "image-missing", GTK_ICON_SIZE_DIALOG);
 
-  if (loaded && !animated)
-    {
-      create_popup_menu ();
-      g_signal_connect (G_OBJECT (ev), "button-press-event", G_CALLBACK (button_handler), NULL);
-      g_signal_connect (G_OBJECT (ev), "key-press-event", G_CALLBACK (key_handler), NULL);
-    }
+  create_popup_menu ();
+  g_signal_connect (G_OBJECT (ev), "button-press-event", G_CALLBACK (button_handler), NULL);
+  g_signal_connect (G_OBJECT (ev), "key-press-event", G_CALLBACK (key_handler), NULL);
 
   return sw;
 }
@@ -0,0 +1,517 @@
+/*
+ * This file is part of YAD.
+ *
+ * YAD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YAD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YAD. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2008-2019, Victor Ananjevsky <ananasik@gmail.com>
+ */
+
+#include "yad.h"
+
+/* number of previews kept in memory */
+#define PREVIEW_CACHE_SIZE 32
+/* max number of threads for thumbnails prefetching */
+#define PREFETCH_THREADS 4
+
+typedef struct {
+  GtkFileChooser *chooser;
+  GtkWidget *image;
+  guint serial;
+  GCancellable *cancel;
+} PreviewData;
+
+typedef struct {
+  PreviewData *pd;
+  guint serial;
+  gchar *uri;
+  GCancellable *cancel;
+  GdkPixbuf *pb;
+  guint64 mtime;
+} PreviewRequest;
+
+typedef struct {
+  gchar *uri;
+  GdkPixbuf *pb;
+  guint64 mtime;                /* modification time of file when preview was made */
+} PreviewItem;
+
+typedef struct {
+  GFile *file;
+  gboolean folder;
+  GCancellable *cancel;
+} PrefetchTask;
+
+static GThreadPool *preview_pool = NULL;
+
+static GQueue preview_lru = G_QUEUE_INIT;
+static GHashTable *preview_cache = NULL;
+
+static GThreadPool *prefetch_pool = NULL;
+static GHashTable *image_types = NULL;
+
+/* get path of freedesktop thumbnail for uri */
+static gchar *
+get_thumb_path (const gchar *uri)
+{
+  gchar *sum, *name, *path;
+
+  sum = g_compute_checksum_for_string (G_CHECKSUM_MD5, uri, -1);
+  name = g_strdup_printf ("%s.png", sum);
+  path = g_build_filename (g_get_user_cache_dir (), "thumbnails",
+                           options.common_data.large_preview ? "large" : "normal", name, NULL);
+  g_free (sum);
+  g_free (name);
+
+  return path;
+}
+
+static guint64
+get_mtime (GFile *file, GCancellable *cancel)
+{
+  GFileInfo *info;
+  guint64 mtime = 0;
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_TIME_MODIFIED, G_FILE_QUERY_INFO_NONE, cancel, NULL);
+  if (info)
+    {
+      mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+      g_object_unref (info);
+    }
+
+  return mtime;
+}
+
+/* load existing thumbnail if it is up to date */
+static GdkPixbuf *
+load_thumbnail (const gchar *path, guint64 mtime)
+{
+  GdkPixbuf *pb;
+  const gchar *tm;
+
+  pb = gdk_pixbuf_new_from_file (path, NULL);
+  if (!pb)
+    return NULL;
+
+  tm = gdk_pixbuf_get_option (pb, "tEXt::Thumb::MTime");
+  if (mtime && tm && g_ascii_strtoull (tm, NULL, 10) != mtime)
+    {
+      g_object_unref (pb);
+      pb = NULL;
+    }
+
+  return pb;
+}
+
+static GdkPixbuf *
+create_thumbnail (GFile *file, GCancellable *cancel)
+{
+  GFileInputStream *in;
+  GdkPixbuf *pb = NULL;
+  gint size = options.common_data.large_preview ? 256 : 128;
+
+  in = g_file_read (file, cancel, NULL);
+  if (in)
+    {
+      pb = gdk_pixbuf_new_from_stream_at_scale (G_INPUT_STREAM (in), size, size, TRUE, cancel, NULL);
+      g_object_unref (in);
+    }
+
+  return pb;
+}
+
+static void
+save_thumbnail (GdkPixbuf *pb, const gchar *uri, const gchar *path, guint64 mtime)
+{
+  gchar *dir, *smtime, *buf;
+  gsize size;
+
+  dir = g_path_get_dirname (path);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  smtime = g_strdup_printf ("%" G_GUINT64_FORMAT, mtime);
+  if (gdk_pixbuf_save_to_buffer (pb, &buf, &size, "png", NULL,
+                                 "tEXt::Thumb::URI", uri,
+                                 "tEXt::Thumb::MTime", smtime,
+                                 NULL))
+    {
+      /* file is replaced atomically, so nobody reads half-written thumbnail */
+      g_file_set_contents (path, buf, size, NULL);
+      g_free (buf);
+    }
+  g_free (smtime);
+}
+
+static GdkPixbuf *
+lookup_preview (const gchar *uri)
+{
+  GList *link;
+  GFile *file;
+  guint64 mtime = 0;
+
+  if (!preview_cache)
+    return NULL;
+
+  link = g_hash_table_lookup (preview_cache, uri);
+  if (!link)
+    return NULL;
+
+  /* file was changed after preview was made. remote files are checked in background */
+  file = g_file_new_for_uri (uri);
+  if (g_file_is_native (file))
+    mtime = get_mtime (file, NULL);
+  g_object_unref (file);
+  if (mtime != ((PreviewItem *) link->data)->mtime)
+    return NULL;
+
+  /* move to the head of queue */
+  g_queue_unlink (&preview_lru, link);
+  g_queue_push_head_link (&preview_lru, link);
+
+  return ((PreviewItem *) link->data)->pb;
+}
+
+static void
+cache_preview (const gchar *uri, GdkPixbuf *pb, guint64 mtime)
+{
+  PreviewItem *item;
+  GList *link;
+
+  if (!preview_cache)
+    preview_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  link = g_hash_table_lookup (preview_cache, uri);
+  if (link)
+    {
+      item = (PreviewItem *) link->data;
+      g_object_unref (item->pb);
+      item->pb = g_object_ref (pb);
+      item->mtime = mtime;
+      g_queue_unlink (&preview_lru, link);
+      g_queue_push_head_link (&preview_lru, link);
+      return;
+    }
+
+  item = g_new0 (PreviewItem, 1);
+  item->uri = g_strdup (uri);
+  item->pb = g_object_ref (pb);
+  item->mtime = mtime;
+  g_queue_push_head (&preview_lru, item);
+  g_hash_table_insert (preview_cache, item->uri, preview_lru.head);
+
+  /* drop least recently used preview */
+  if (g_queue_get_length (&preview_lru) > PREVIEW_CACHE_SIZE)
+    {
+      item = (PreviewItem *) g_queue_pop_tail (&preview_lru);
+      g_hash_table_remove (preview_cache, item->uri);
+      g_object_unref (item->pb);
+      g_free (item->uri);
+      g_free (item);
+    }
+}
+
+static void
+show_preview (PreviewData *pd, GdkPixbuf *pb)
+{
+  if (pb)
+    {
+      gtk_image_set_from_pixbuf (GTK_IMAGE (pd->image), pb);
+      gtk_file_chooser_set_preview_widget_active (pd->chooser, TRUE);
+    }
+  else
+    gtk_file_chooser_set_preview_widget_active (pd->chooser, FALSE);
+}
+
+static gboolean
+preview_done (PreviewRequest *req)
+{
+  PreviewData *pd = req->pd;
+
+  if (req->pb)
+    {
+      cache_preview (req->uri, req->pb, req->mtime);
+      g_object_unref (req->pb);
+    }
+
+  /* show result of the last request only */
+  if (req->serial == pd->serial)
+    show_preview (pd, req->pb);
+
+  g_object_unref (req->cancel);
+  g_free (req->uri);
+  g_free (req);
+
+  g_object_unref (pd->chooser);
+  g_object_unref (pd->image);
+
+  return FALSE;
+}
+
+static void
+preview_thread (PreviewRequest *req, gpointer data)
+{
+  GFile *file;
+  GdkPixbuf *pb = NULL;
+  gchar *path, *uri = NULL;
+  guint64 mtime;
+
+  /* request is outdated */
+  if (g_cancellable_is_cancelled (req->cancel))
+    {
+      g_idle_add ((GSourceFunc) preview_done, req);
+      return;
+    }
+
+  file = g_file_new_for_uri (req->uri);
+  path = get_thumb_path (req->uri);
+  mtime = get_mtime (file, req->cancel);
+  req->mtime = mtime;
+
+  req->pb = load_thumbnail (path, mtime);
+  if (!req->pb && !g_cancellable_is_cancelled (req->cancel))
+    {
+      req->pb = create_thumbnail (file, req->cancel);
+      if (req->pb)
+        {
+          pb = g_object_ref (req->pb);
+          uri = g_strdup (req->uri);
+        }
+    }
+  g_object_unref (file);
+
+  /* show preview before the thumbnail is written */
+  g_idle_add ((GSourceFunc) preview_done, req);
+
+  if (pb)
+    {
+      save_thumbnail (pb, uri, path, mtime);
+      g_object_unref (pb);
+      g_free (uri);
+    }
+  g_free (path);
+}
+
+static void
+free_preview_data (PreviewData *pd)
+{
+  if (pd->cancel)
+    {
+      g_cancellable_cancel (pd->cancel);
+      g_object_unref (pd->cancel);
+    }
+  g_free (pd);
+}
+
+void
+update_preview (GtkFileChooser * chooser, GtkWidget *p)
+{
+  PreviewData *pd;
+  PreviewRequest *req;
+  GdkPixbuf *pb;
+  gchar *uri;
+
+  pd = (PreviewData *) g_object_get_data (G_OBJECT (p), "yad-preview");
+  if (!pd)
+    {
+      pd = g_new0 (PreviewData, 1);
+      pd->chooser = chooser;
+      pd->image = p;
+      g_object_set_data_full (G_OBJECT (p), "yad-preview", pd, (GDestroyNotify) free_preview_data);
+    }
+
+  /* cancel previous request */
+  pd->serial++;
+  if (pd->cancel)
+    {
+      g_cancellable_cancel (pd->cancel);
+      g_object_unref (pd->cancel);
+      pd->cancel = NULL;
+    }
+
+  uri = gtk_file_chooser_get_preview_uri (chooser);
+  if (!uri)
+    {
+      gtk_file_chooser_set_preview_widget_active (chooser, FALSE);
+      return;
+    }
+
+  /* recently shown preview */
+  pb = lookup_preview (uri);
+  if (pb)
+    {
+      show_preview (pd, pb);
+      g_free (uri);
+      return;
+    }
+
+  if (!preview_pool)
+    preview_pool = g_thread_pool_new ((GFunc) preview_thread, NULL, 1, FALSE, NULL);
+
+  pd->cancel = g_cancellable_new ();
+
+  req = g_new0 (PreviewRequest, 1);
+  req->pd = pd;
+  req->serial = pd->serial;
+  req->uri = uri;
+  req->cancel = g_object_ref (pd->cancel);
+
+  /* keep widgets alive until request is done */
+  g_object_ref (pd->chooser);
+  g_object_ref (pd->image);
+
+  g_thread_pool_push (preview_pool, req, NULL);
+}
+
+/* collect mime types supported by gdk-pixbuf */
+static void
+init_image_types ()
+{
+  GSList *formats, *f;
+
+  image_types = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  formats = gdk_pixbuf_get_formats ();
+  for (f = formats; f; f = f->next)
+    {
+      gchar **mimes = gdk_pixbuf_format_get_mime_types ((GdkPixbufFormat *) f->data);
+      guint i;
+
+      for (i = 0; mimes[i]; i++)
+        g_hash_table_add (image_types, mimes[i]);
+      g_free (mimes);
+    }
+  g_slist_free (formats);
+}
+
+static void
+push_prefetch (GFile *file, gboolean folder, GCancellable *cancel)
+{
+  PrefetchTask *task;
+
+  task = g_new0 (PrefetchTask, 1);
+  task->file = file;
+  task->folder = folder;
+  task->cancel = g_object_ref (cancel);
+
+  g_thread_pool_push (prefetch_pool, task, NULL);
+}
+
+static void
+scan_folder (GFile *dir, GCancellable *cancel)
+{
+  GFileEnumerator *en;
+  GFileInfo *info;
+
+  en = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                  G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
+                                  G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE,
+                                  G_FILE_QUERY_INFO_NONE, cancel, NULL);
+  if (!en)
+    return;
+
+  while ((info = g_file_enumerator_next_file (en, cancel, NULL)) != NULL)
+    {
+      const gchar *type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+
+      if (type && (options.common_data.show_hidden || !g_file_info_get_is_hidden (info)))
+        {
+          gchar *mime = g_content_type_get_mime_type (type);
+
+          /* add image files only */
+          if (mime && g_hash_table_contains (image_types, mime))
+            push_prefetch (g_file_get_child (dir, g_file_info_get_name (info)), FALSE, cancel);
+          g_free (mime);
+        }
+      g_object_unref (info);
+    }
+  g_object_unref (en);
+}
+
+static void
+prefetch_thumbnail (GFile *file, GCancellable *cancel)
+{
+  GdkPixbuf *pb;
+  gchar *uri, *path;
+  guint64 mtime;
+
+  uri = g_file_get_uri (file);
+  path = get_thumb_path (uri);
+  mtime = get_mtime (file, cancel);
+
+  pb = load_thumbnail (path, mtime);
+  if (!pb && !g_cancellable_is_cancelled (cancel))
+    {
+      pb = create_thumbnail (file, cancel);
+      if (pb)
+        save_thumbnail (pb, uri, path, mtime);
+    }
+
+  if (pb)
+    g_object_unref (pb);
+  g_free (path);
+  g_free (uri);
+}
+
+static void
+prefetch_thread (PrefetchTask *task, gpointer data)
+{
+  /* skip tasks for previous folders */
+  if (!g_cancellable_is_cancelled (task->cancel))
+    {
+      if (task->folder)
+        scan_folder (task->file, task->cancel);
+      else
+        prefetch_thumbnail (task->file, task->cancel);
+    }
+
+  g_object_unref (task->file);
+  g_object_unref (task->cancel);
+  g_free (task);
+}
+
+/* create thumbnails for images from chooser's current folder */
+void
+prefetch_previews (GtkFileChooser *chooser, gpointer data)
+{
+  GCancellable *cancel;
+  gchar *uri;
+
+  uri = gtk_file_chooser_get_current_folder_uri (chooser);
+  if (!uri)
+    return;
+
+  /* folder is already processed */
+  if (g_strcmp0 (uri, g_object_get_data (G_OBJECT (chooser), "yad-prefetch-uri")) == 0)
+    {
+      g_free (uri);
+      return;
+    }
+  g_object_set_data_full (G_OBJECT (chooser), "yad-prefetch-uri", uri, g_free);
+
+  /* stop work for previous folder */
+  cancel = (GCancellable *) g_object_get_data (G_OBJECT (chooser), "yad-prefetch");
+  if (cancel)
+    g_cancellable_cancel (cancel);
+  cancel = g_cancellable_new ();
+  g_object_set_data_full (G_OBJECT (chooser), "yad-prefetch", cancel, g_object_unref);
+
+  if (!prefetch_pool)
+    {
+      init_image_types ();
+      prefetch_pool = g_thread_pool_new ((GFunc) prefetch_thread, NULL,
+                                         MIN (g_get_num_processors (), PREFETCH_THREADS), FALSE, NULL);
+    }
+
+  push_prefetch (g_file_new_for_uri (uri), TRUE, cancel);
+}
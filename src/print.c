@@ -22,6 +22,7 @@
 
 #include <gtk/gtkunixprint.h>
 #include <errno.h>
+#include <string.h>
 
 #include "yad.h"
 
@@ -31,9 +32,50 @@
 
 #define FONTNAME "Monospace"
 #define FONTSIZE 11.0
+#define TABLE_FONT "Sans 10"
+#define CELL_PAD 4.0
+#define INDENT 12.0
 
-static gchar **text;
-static gint nlines, npages;
+/* number of text lines or rows processed at once while paginating */
+#define PAGINATE_LINES 1000
+
+typedef struct {
+  gsize offset;                 /* position of first text line or row */
+  gint subline;                 /* first line of wrapped text line */
+} PageStart;
+
+/* get text line at position pos. sets length of line and position of the next one */
+typedef const gchar *(*GetLineFunc) (gsize pos, gsize *len, gsize *next);
+
+static GetLineFunc get_line = NULL;
+static gsize text_end = 0;
+
+/* file source */
+static GMappedFile *map = NULL;
+static const gchar *text = NULL;
+
+/* text buffer source */
+static GtkTextBuffer *print_buffer = NULL;
+static gchar *line_buf = NULL;
+
+/* tree view source */
+static GtkTreeView *print_view = NULL;
+static GPtrArray *print_cols = NULL;
+static gdouble *col_x = NULL;
+static GtkTreeIter row_iter;
+static gsize row_pos;
+static gint row_depth;
+static gboolean row_valid = FALSE;
+
+static const gchar *header_title = "";
+
+static PangoLayout *text_layout = NULL;
+static GArray *pages = NULL;
+static gdouble page_height;
+
+/* pagination state */
+static gsize pg_offset;
+static gdouble pg_height;
 
 static PangoFontDescription *fdesc = NULL;
 
@@ -55,7 +97,7 @@ draw_header (GtkPrintContext * cnt, gint pn, gint pc)
   pango_layout_set_font_description (layout, desc);
   pango_font_description_free (desc);
 
-  pango_layout_set_text (layout, options.common_data.uri, -1);
+  pango_layout_set_text (layout, header_title, -1);
   pango_layout_get_pixel_size (layout, &tw, &th);
   if (tw > pw)
     {
@@ -86,69 +128,549 @@ draw_header (GtkPrintContext * cnt, gint pn, gint pc)
   cairo_stroke (cr);
 }
 
-static void
-begin_print_text (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+static const gchar *
+file_line (gsize pos, gsize *len, gsize *next)
 {
-  gchar *buf;
-  gint i = 0;
-  gdouble ph;
+  const gchar *end;
 
-  /* load file */
-  g_file_get_contents (options.common_data.uri, &buf, NULL, NULL);
-  text = g_strsplit (buf, "\n", 0);
-  g_free (buf);
+  end = memchr (text + pos, '\n', text_end - pos);
+  if (end)
+    {
+      *next = end - text + 1;
+      *len = end - text - pos;
+    }
+  else
+    {
+      *next = text_end;
+      *len = text_end - pos;
+    }
 
-  while (text[i] != NULL)
-    i++;
+  return text + pos;
+}
 
-  ph = gtk_print_context_get_height (cnt);
-  if (options.print_data.headers)
-    ph -= HEADER_HEIGHT + HEADER_GAP;
+static const gchar *
+buffer_line (gsize pos, gsize *len, gsize *next)
+{
+  GtkTextIter start, end;
+
+  g_free (line_buf);
+
+  gtk_text_buffer_get_iter_at_line (print_buffer, &start, pos);
+  end = start;
+  if (!gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+  line_buf = gtk_text_buffer_get_text (print_buffer, &start, &end, FALSE);
+
+  *len = strlen (line_buf);
+  *next = pos + 1;
+
+  return line_buf;
+}
 
-  nlines = ph / FONTSIZE;
-  npages = i / nlines + 1;
-  gtk_print_operation_set_n_pages (op, npages);
+static gdouble
+get_line_height (PangoLayoutIter *it)
+{
+  PangoRectangle r;
+
+  pango_layout_iter_get_line_extents (it, NULL, &r);
+  return (gdouble) r.height / PANGO_SCALE;
+}
+
+static void
+init_pages (GtkPrintContext * cnt, const gchar *font)
+{
+  PageStart ps = { 0, 0 };
+
+  page_height = gtk_print_context_get_height (cnt);
+  if (options.print_data.headers)
+    page_height -= HEADER_HEIGHT + HEADER_GAP;
 
   /* set font */
   if (options.common_data.font)
     fdesc = pango_font_description_from_string (options.common_data.font);
   else
     {
-      fdesc = pango_font_description_from_string (FONTNAME);
-      pango_font_description_set_size (fdesc, FONTSIZE * PANGO_SCALE);
+      fdesc = pango_font_description_from_string (font);
+      if (pango_font_description_get_size (fdesc) == 0)
+        pango_font_description_set_size (fdesc, FONTSIZE * PANGO_SCALE);
     }
+
+  text_layout = gtk_print_context_create_pango_layout (cnt);
+  pango_layout_set_font_description (text_layout, fdesc);
+  pango_layout_set_width (text_layout, gtk_print_context_get_width (cnt) * PANGO_SCALE);
+  pango_layout_set_wrap (text_layout, PANGO_WRAP_WORD_CHAR);
+
+  pages = g_array_new (FALSE, FALSE, sizeof (PageStart));
+  g_array_append_val (pages, ps);
+  pg_offset = 0;
+  pg_height = 0;
+}
+
+static void
+begin_print_text (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  GError *err = NULL;
+
+  /* map file. pages are read by system on demand */
+  map = g_mapped_file_new (options.common_data.uri, FALSE, &err);
+  if (!map)
+    {
+      g_printerr (_("Cannot open file %s: %s\n"), options.common_data.uri, err->message);
+      g_error_free (err);
+      gtk_print_operation_cancel (op);
+      return;
+    }
+  text = g_mapped_file_get_contents (map);
+  text_end = g_mapped_file_get_length (map);
+  get_line = file_line;
+
+  init_pages (cnt, FONTNAME);
+}
+
+static void
+begin_print_buffer (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  text_end = gtk_text_buffer_get_line_count (print_buffer);
+  get_line = buffer_line;
+
+  init_pages (cnt, FONTNAME);
+}
+
+/* build page index using real sizes of (possibly wrapped) lines */
+static gboolean
+paginate_text (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  gint n;
+
+  /* source is not loaded */
+  if (!pages)
+    return TRUE;
+
+  for (n = 0; n < PAGINATE_LINES && pg_offset < text_end; n++)
+    {
+      PangoLayoutIter *it;
+      const gchar *line;
+      gsize len, next;
+      gint sub = 0;
+
+      line = get_line (pg_offset, &len, &next);
+      pango_layout_set_text (text_layout, line, len);
+
+      it = pango_layout_get_iter (text_layout);
+      do
+        {
+          gdouble lh = get_line_height (it);
+
+          if (pg_height > 0 && pg_height + lh > page_height)
+            {
+              PageStart ps = { pg_offset, sub };
+              g_array_append_val (pages, ps);
+              pg_height = 0;
+            }
+          pg_height += lh;
+          sub++;
+        }
+      while (pango_layout_iter_next_line (it));
+      pango_layout_iter_free (it);
+
+      pg_offset = next;
+    }
+
+  if (pg_offset < text_end)
+    return FALSE;
+
+  gtk_print_operation_set_n_pages (op, pages->len);
+  return TRUE;
 }
 
 static void
 draw_page_text (GtkPrintOperation * op, GtkPrintContext * cnt, gint page, gpointer data)
 {
   cairo_t *cr;
-  PangoLayout *layout;
-  gint i, line;
+  PageStart *ps, end = { text_end, 0 };
+  gsize offset;
+  gint sub;
+  gdouble top, y = 0;
 
   cr = gtk_print_context_get_cairo_context (cnt);
 
   /* create header */
+  top = 0;
   if (options.print_data.headers)
-    draw_header (cnt, page + 1, npages);
+    {
+      draw_header (cnt, page + 1, pages->len);
+      top = HEADER_HEIGHT + HEADER_GAP;
+    }
 
   /* add text */
-  layout = gtk_print_context_create_pango_layout (cnt);
-  pango_layout_set_font_description (layout, fdesc);
-
-  cairo_move_to (cr, 0, HEADER_HEIGHT + HEADER_GAP);
+  ps = &g_array_index (pages, PageStart, page);
+  if (page + 1 < (gint) pages->len)
+    end = g_array_index (pages, PageStart, page + 1);
 
-  line = page * nlines;
-  for (i = 0; i < nlines; i++)
+  offset = ps->offset;
+  sub = ps->subline;
+  while (offset < end.offset || (offset == end.offset && sub < end.subline))
     {
-      if (text[line + i] == NULL)
+      PangoLayoutIter *it;
+      const gchar *line;
+      gsize len, next;
+      gint i = 0;
+
+      line = get_line (offset, &len, &next);
+      pango_layout_set_text (text_layout, line, len);
+
+      it = pango_layout_get_iter (text_layout);
+      do
+        {
+          PangoRectangle r;
+          gint baseline;
+
+          if (offset == end.offset && i == end.subline)
+            break;
+
+          if (i >= sub)
+            {
+              pango_layout_iter_get_line_extents (it, NULL, &r);
+              baseline = pango_layout_iter_get_baseline (it);
+
+              cairo_move_to (cr, (gdouble) r.x / PANGO_SCALE, top + y + (gdouble) (baseline - r.y) / PANGO_SCALE);
+              pango_cairo_show_layout_line (cr, pango_layout_iter_get_line_readonly (it));
+              y += (gdouble) r.height / PANGO_SCALE;
+            }
+          i++;
+        }
+      while (pango_layout_iter_next_line (it));
+      pango_layout_iter_free (it);
+
+      if (offset == end.offset)
         break;
-      pango_layout_set_text (layout, text[line + i], -1);
-      pango_cairo_show_layout (cr, layout);
-      cairo_rel_move_to (cr, 0, FONTSIZE);
+
+      offset = next;
+      sub = 0;
     }
+}
 
-  g_object_unref (layout);
+/* go to the next row in depth-first order */
+static gboolean
+next_row (GtkTreeModel *model)
+{
+  GtkTreeIter it;
+
+  if (gtk_tree_model_iter_children (model, &it, &row_iter))
+    {
+      row_iter = it;
+      row_depth++;
+      return TRUE;
+    }
+
+  do
+    {
+      it = row_iter;
+      if (gtk_tree_model_iter_next (model, &row_iter))
+        return TRUE;
+      row_depth--;
+    }
+  while (gtk_tree_model_iter_parent (model, &row_iter, &it));
+
+  return FALSE;
+}
+
+/* set row_iter to the row number pos. sequential access is cheap */
+static gboolean
+get_row (gsize pos)
+{
+  GtkTreeModel *model = gtk_tree_view_get_model (print_view);
+
+  if (row_valid && pos == row_pos)
+    return TRUE;
+
+  if (row_valid && pos == row_pos + 1)
+    {
+      row_valid = next_row (model);
+      row_pos = pos;
+      return row_valid;
+    }
+
+  row_depth = 0;
+  if (!options.list_data.tree_mode)
+    row_valid = gtk_tree_model_iter_nth_child (model, &row_iter, NULL, pos);
+  else
+    {
+      row_valid = gtk_tree_model_get_iter_first (model, &row_iter);
+      for (row_pos = 0; row_valid && row_pos < pos; row_pos++)
+        row_valid = next_row (model);
+    }
+  row_pos = pos;
+
+  return row_valid;
+}
+
+static gchar *
+get_cell_text (GtkTreeViewColumn *col)
+{
+  GString *str;
+  GList *cells, *c;
+
+  gtk_tree_view_column_cell_set_cell_data (col, gtk_tree_view_get_model (print_view), &row_iter, FALSE, FALSE);
+
+  /* get text as it shown in view */
+  str = g_string_new (NULL);
+  cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (col));
+  for (c = cells; c; c = c->next)
+    {
+      if (GTK_IS_CELL_RENDERER_TEXT (c->data))
+        {
+          gchar *t;
+
+          g_object_get (G_OBJECT (c->data), "text", &t, NULL);
+          if (t)
+            {
+              g_string_append (str, t);
+              g_free (t);
+            }
+        }
+      else if (GTK_IS_CELL_RENDERER_TOGGLE (c->data))
+        {
+          gboolean active;
+
+          g_object_get (G_OBJECT (c->data), "active", &active, NULL);
+          g_string_append (str, active ? "[x]" : "[ ]");
+        }
+      else if (GTK_IS_CELL_RENDERER_PROGRESS (c->data))
+        {
+          gint val;
+
+          g_object_get (G_OBJECT (c->data), "value", &val, NULL);
+          g_string_append_printf (str, "%d%%", val);
+        }
+    }
+  g_list_free (cells);
+
+  return g_string_free (str, FALSE);
+}
+
+/* layout cell text of current row and return its height */
+static gdouble
+layout_cell (guint n, const gchar *str)
+{
+  gdouble width = col_x[n + 1] - col_x[n] - 2 * CELL_PAD;
+  gint h;
+
+  if (n == 0)
+    width -= row_depth * INDENT;
+
+  pango_layout_set_width (text_layout, MAX (width, 1) * PANGO_SCALE);
+  pango_layout_set_text (text_layout, str, -1);
+  pango_layout_get_size (text_layout, NULL, &h);
+
+  return (gdouble) h / PANGO_SCALE;
+}
+
+static gdouble
+get_row_height ()
+{
+  gdouble rh = 0;
+  guint i;
+
+  for (i = 0; i < print_cols->len; i++)
+    {
+      gchar *str = get_cell_text (g_ptr_array_index (print_cols, i));
+      rh = MAX (rh, layout_cell (i, str));
+      g_free (str);
+    }
+
+  return rh + CELL_PAD;
+}
+
+/* draw column titles. if cr is NULL only calculate their height */
+static gdouble
+draw_titles (cairo_t *cr, gdouble top, gdouble pw)
+{
+  PangoFontDescription *desc;
+  gdouble th = 0;
+  gint depth = row_depth;
+  guint i;
+
+  if (!gtk_tree_view_get_headers_visible (print_view))
+    return 0;
+
+  desc = pango_font_description_copy (fdesc);
+  pango_font_description_set_weight (desc, PANGO_WEIGHT_BOLD);
+  pango_layout_set_font_description (text_layout, desc);
+
+  for (i = 0; i < print_cols->len; i++)
+    {
+      const gchar *t = gtk_tree_view_column_get_title (g_ptr_array_index (print_cols, i));
+
+      row_depth = 0;
+      th = MAX (th, layout_cell (i, t ? t : ""));
+      if (cr)
+        {
+          cairo_move_to (cr, col_x[i] + CELL_PAD, top);
+          pango_cairo_show_layout (cr, text_layout);
+        }
+    }
+  th += CELL_PAD;
+
+  pango_layout_set_font_description (text_layout, fdesc);
+  pango_font_description_free (desc);
+
+  if (cr)
+    {
+      cairo_move_to (cr, 0, top + th);
+      cairo_line_to (cr, pw, top + th);
+      cairo_set_source_rgb (cr, 0, 0, 0);
+      cairo_set_line_width (cr, 0.5);
+      cairo_stroke (cr);
+    }
+
+  /* keep cached row valid */
+  row_depth = depth;
+
+  return th + CELL_PAD;
+}
+
+static void
+begin_print_table (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  GList *cols, *c;
+  gdouble pw, tw = 0;
+  guint i;
+
+  init_pages (cnt, TABLE_FONT);
+
+  /* column widths are proportional to widths in view */
+  print_cols = g_ptr_array_new ();
+  cols = gtk_tree_view_get_columns (print_view);
+  for (c = cols; c; c = c->next)
+    {
+      if (gtk_tree_view_column_get_visible (GTK_TREE_VIEW_COLUMN (c->data)))
+        {
+          g_ptr_array_add (print_cols, c->data);
+          tw += MAX (gtk_tree_view_column_get_width (GTK_TREE_VIEW_COLUMN (c->data)), 1);
+        }
+    }
+  g_list_free (cols);
+
+  pw = gtk_print_context_get_width (cnt);
+  col_x = g_new0 (gdouble, print_cols->len + 1);
+  for (i = 0; i < print_cols->len; i++)
+    col_x[i + 1] = col_x[i] + pw * MAX (gtk_tree_view_column_get_width (g_ptr_array_index (print_cols, i)), 1) / tw;
+
+  /* titles are repeated on each page */
+  page_height -= draw_titles (NULL, 0, pw);
+
+  row_valid = FALSE;
+}
+
+/* rows are not splitted between pages */
+static gboolean
+paginate_table (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  gint n;
+
+  if (print_cols->len == 0)
+    {
+      gtk_print_operation_set_n_pages (op, 1);
+      return TRUE;
+    }
+
+  for (n = 0; n < PAGINATE_LINES; n++)
+    {
+      gdouble rh;
+
+      if (!get_row (pg_offset))
+        {
+          gtk_print_operation_set_n_pages (op, pages->len);
+          return TRUE;
+        }
+
+      rh = get_row_height ();
+      if (pg_height > 0 && pg_height + rh > page_height)
+        {
+          PageStart ps = { pg_offset, 0 };
+          g_array_append_val (pages, ps);
+          pg_height = 0;
+        }
+      pg_height += rh;
+      pg_offset++;
+    }
+
+  return FALSE;
+}
+
+static void
+draw_page_table (GtkPrintOperation * op, GtkPrintContext * cnt, gint page, gpointer data)
+{
+  cairo_t *cr;
+  gsize pos, end = G_MAXSIZE;
+  gdouble y;
+
+  cr = gtk_print_context_get_cairo_context (cnt);
+
+  y = 0;
+  if (options.print_data.headers)
+    {
+      draw_header (cnt, page + 1, pages->len);
+      y = HEADER_HEIGHT + HEADER_GAP;
+    }
+  y += draw_titles (cr, y, gtk_print_context_get_width (cnt));
+
+  if (page + 1 < (gint) pages->len)
+    end = g_array_index (pages, PageStart, page + 1).offset;
+
+  for (pos = g_array_index (pages, PageStart, page).offset; pos < end && get_row (pos); pos++)
+    {
+      gdouble rh = 0;
+      guint i;
+
+      for (i = 0; i < print_cols->len; i++)
+        {
+          gchar *str = get_cell_text (g_ptr_array_index (print_cols, i));
+          gdouble x = col_x[i] + CELL_PAD;
+
+          if (i == 0)
+            x += row_depth * INDENT;
+
+          rh = MAX (rh, layout_cell (i, str));
+          cairo_move_to (cr, x, y);
+          pango_cairo_show_layout (cr, text_layout);
+          g_free (str);
+        }
+      y += rh + CELL_PAD;
+    }
+}
+
+static void
+end_print_text (GtkPrintOperation * op, GtkPrintContext * cnt, gpointer data)
+{
+  if (text_layout)
+    g_object_unref (text_layout);
+  text_layout = NULL;
+
+  if (pages)
+    g_array_free (pages, TRUE);
+  pages = NULL;
+
+  if (fdesc)
+    pango_font_description_free (fdesc);
+  fdesc = NULL;
+
+  if (map)
+    g_mapped_file_unref (map);
+  map = NULL;
+  text = NULL;
+  text_end = 0;
+
+  g_free (line_buf);
+  line_buf = NULL;
+
+  if (print_cols)
+    g_ptr_array_free (print_cols, TRUE);
+  print_cols = NULL;
+  g_free (col_x);
+  col_x = NULL;
+  row_valid = FALSE;
 }
 
 static void
@@ -243,12 +765,108 @@ save_settings (GtkPrintSettings *print_settings, GtkPageSetup *page_setup)
   return res;
 }
 
+static void
+load_settings (GtkPrintSettings **print_settings, GtkPageSetup **page_setup)
+{
+  gchar *fn;
+
+  fn = g_build_filename (g_get_user_config_dir (), "yad", "print.conf", NULL);
+  if (g_file_test (fn, G_FILE_TEST_EXISTS))
+    {
+      *print_settings = gtk_print_settings_new_from_file (fn, NULL);
+      *page_setup = gtk_page_setup_new_from_file (fn, NULL);
+    }
+  g_free (fn);
+
+  if (!*print_settings)
+    *print_settings = gtk_print_settings_new ();
+  if (!*page_setup)
+    *page_setup = gtk_page_setup_new ();
+}
+
+/* print dialog contents with standard print dialog */
+static void
+run_print_operation (GtkWindow *parent, GCallback begin, GCallback paginate, GCallback draw)
+{
+  GtkPrintOperation *op;
+  GtkPrintSettings *print_settings = NULL;
+  GtkPageSetup *page_setup = NULL;
+  GtkPrintOperationResult res;
+  gchar *job_name;
+  GError *err = NULL;
+
+  load_settings (&print_settings, &page_setup);
+
+  header_title = parent ? gtk_window_get_title (parent) : NULL;
+  if (!header_title)
+    header_title = "";
+
+  op = gtk_print_operation_new ();
+  gtk_print_operation_set_unit (op, GTK_UNIT_POINTS);
+  gtk_print_operation_set_print_settings (op, print_settings);
+  gtk_print_operation_set_default_page_setup (op, page_setup);
+  gtk_print_operation_set_embed_page_setup (op, TRUE);
+  job_name = g_strdup_printf ("yad-%d", getpid ());
+  gtk_print_operation_set_job_name (op, job_name);
+  g_free (job_name);
+
+  g_signal_connect (G_OBJECT (op), "begin-print", begin, NULL);
+  g_signal_connect (G_OBJECT (op), "paginate", paginate, NULL);
+  g_signal_connect (G_OBJECT (op), "draw-page", draw, NULL);
+  g_signal_connect (G_OBJECT (op), "end-print", G_CALLBACK (end_print_text), NULL);
+
+  res = gtk_print_operation_run (op, GTK_PRINT_OPERATION_ACTION_PRINT_DIALOG, parent, &err);
+  if (res == GTK_PRINT_OPERATION_RESULT_ERROR)
+    {
+      g_printerr (_("Printing failed: %s\n"), err->message);
+      g_error_free (err);
+    }
+  else if (res == GTK_PRINT_OPERATION_RESULT_APPLY)
+    save_settings (gtk_print_operation_get_print_settings (op), gtk_print_operation_get_default_page_setup (op));
+
+  g_object_unref (op);
+  g_object_unref (print_settings);
+  g_object_unref (page_setup);
+}
+
+void
+print_text_buffer (GtkTextBuffer *buf, GtkWindow *parent)
+{
+  print_buffer = buf;
+  run_print_operation (parent, G_CALLBACK (begin_print_buffer), G_CALLBACK (paginate_text), G_CALLBACK (draw_page_text));
+  print_buffer = NULL;
+}
+
+/* model can be changed while printing. drop cached row in this case */
+static void
+model_changed_cb (GtkTreeModel *model)
+{
+  row_valid = FALSE;
+}
+
+void
+print_tree_view (GtkTreeView *view, GtkWindow *parent)
+{
+  GtkTreeModel *model = gtk_tree_view_get_model (view);
+  gulong ins, del;
+
+  ins = g_signal_connect (G_OBJECT (model), "row-inserted", G_CALLBACK (model_changed_cb), NULL);
+  del = g_signal_connect (G_OBJECT (model), "row-deleted", G_CALLBACK (model_changed_cb), NULL);
+
+  print_view = view;
+  run_print_operation (parent, G_CALLBACK (begin_print_table), G_CALLBACK (paginate_table), G_CALLBACK (draw_page_table));
+  print_view = NULL;
+
+  g_signal_handler_disconnect (G_OBJECT (model), ins);
+  g_signal_handler_disconnect (G_OBJECT (model), del);
+}
+
 gint
 yad_print_run (void)
 {
   GtkWidget *dlg;
   GtkWidget *box, *img, *lbl;
-  gchar *uri, *fn, *job_name = NULL;
+  gchar *uri, *job_name = NULL;
   GtkPrintCapabilities pcap;
   GtkPrintOperationAction act = GTK_PRINT_OPERATION_ACTION_PRINT;
   GtkPrintSettings *print_settings = NULL;
@@ -272,18 +890,8 @@ yad_print_run (void)
     }
 
   /* load previously saved print settings */
-  fn = g_build_filename (g_get_user_config_dir (), "yad", "print.conf", NULL);
-  if (g_file_test (fn, G_FILE_TEST_EXISTS))
-    {
-      print_settings = gtk_print_settings_new_from_file (fn, NULL);
-      page_setup = gtk_page_setup_new_from_file (fn, NULL);
-    }
-  g_free (fn);
-
-  if (!print_settings)
-    print_settings = gtk_print_settings_new ();
-  if (!page_setup)
-    page_setup = gtk_page_setup_new ();
+  load_settings (&print_settings, &page_setup);
+  header_title = options.common_data.uri;
 
   /* create print dialog */
   dlg = gtk_print_unix_dialog_new (options.data.dialog_title, NULL);
@@ -398,7 +1006,9 @@ yad_print_run (void)
                 {
                 case YAD_PRINT_TEXT:
                   g_signal_connect (G_OBJECT (op), "begin-print", G_CALLBACK (begin_print_text), NULL);
+                  g_signal_connect (G_OBJECT (op), "paginate", G_CALLBACK (paginate_text), NULL);
                   g_signal_connect (G_OBJECT (op), "draw-page", G_CALLBACK (draw_page_text), NULL);
+                  g_signal_connect (G_OBJECT (op), "end-print", G_CALLBACK (end_print_text), NULL);
                   break;
                 case YAD_PRINT_IMAGE:
                   gtk_print_operation_set_n_pages (op, 1);
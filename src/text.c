@@ -152,6 +152,13 @@ key_press_cb (GtkWidget * w, GdkEventKey * key, gpointer data)
       show_search ();
       return TRUE;
     }
+  else if ((key->state & GDK_CONTROL_MASK) && (key->keyval == GDK_KEY_P || key->keyval == GDK_KEY_p))
+    {
+      GtkWidget *top = gtk_widget_get_toplevel (w);
+
+      print_text_buffer (GTK_TEXT_BUFFER (text_buffer), gtk_widget_is_toplevel (top) ? GTK_WINDOW (top) : NULL);
+      return TRUE;
+    }
 
   return FALSE;
 }
@@ -267,95 +267,6 @@ get_color (GdkRGBA *c)
 }
 #endif
 
-void
-update_preview (GtkFileChooser * chooser, GtkWidget *p)
-{
-  gchar *uri;
-  static gchar *normal_path = NULL;
-  static gchar *large_path = NULL;
-
-  /* init thumbnails path */
-  if (!normal_path)
-    normal_path = g_build_filename (g_get_user_cache_dir (), "thumbnails", "normal", NULL);
-  if (!large_path)
-    large_path = g_build_filename (g_get_user_cache_dir (), "thumbnails", "large", NULL);
-
-  /* load preview */
-  uri = gtk_file_chooser_get_preview_uri (chooser);
-  if (uri)
-    {
-      gchar *file;
-      GChecksum *chs;
-      GdkPixbuf *pb = NULL;
-
-      chs = g_checksum_new (G_CHECKSUM_MD5);
-      g_checksum_update (chs, (const guchar *) uri, -1);
-      /* first try to get preview from large thumbnail */
-      file = g_strdup_printf ("%s/%s.png", large_path, g_checksum_get_string (chs));
-      if (options.common_data.large_preview && g_file_test (file, G_FILE_TEST_EXISTS))
-        pb = gdk_pixbuf_new_from_file (file, NULL);
-      else
-        {
-          /* try to get preview from normal thumbnail */
-          g_free (file);
-          file = g_strdup_printf ("%s/%s.png", normal_path, g_checksum_get_string (chs));
-          if (!options.common_data.large_preview && g_file_test (file, G_FILE_TEST_EXISTS))
-            pb = gdk_pixbuf_new_from_file (file, NULL);
-          else
-            {
-              /* try to create it */
-              g_free (file);
-              file = g_filename_from_uri (uri, NULL, NULL);
-              if (options.common_data.large_preview)
-                pb = gdk_pixbuf_new_from_file_at_scale (file, 256, 256, TRUE, NULL);
-              else
-                pb = gdk_pixbuf_new_from_file_at_scale (file, 128, 128, TRUE, NULL);
-              if (pb)
-                {
-                  struct stat st;
-                  gchar *smtime;
-
-                  stat (file, &st);
-                  smtime = g_strdup_printf ("%d", st.st_mtime);
-                  g_free (file);
-
-                  /* save thumbnail */
-                  if (options.common_data.large_preview)
-                    {
-                      g_mkdir_with_parents (large_path, 0755);
-                      file = g_strdup_printf ("%s/%s.png", large_path, g_checksum_get_string (chs));
-                    }
-                  else
-                    {
-                      g_mkdir_with_parents (normal_path, 0755);
-                      file = g_strdup_printf ("%s/%s.png", normal_path, g_checksum_get_string (chs));
-                    }
-                  gdk_pixbuf_save (pb, file, "png", NULL,
-                                   "tEXt::Thumb::URI", uri,
-                                   "tEXt::Thumb::MTime", smtime,
-                                   NULL);
-                  g_free (smtime);
-                }
-            }
-        }
-      g_checksum_free (chs);
-      g_free (file);
-
-      if (pb)
-        {
-          gtk_image_set_from_pixbuf (GTK_IMAGE (p), pb);
-          g_object_unref (pb);
-          gtk_file_chooser_set_preview_widget_active (chooser, TRUE);
-        }
-      else
-        gtk_file_chooser_set_preview_widget_active (chooser, FALSE);
-
-      g_free (uri);
-    }
-  else
-    gtk_file_chooser_set_preview_widget_active (chooser, FALSE);
-}
-
 gchar **
 split_arg (const gchar *str)
 {
@@ -586,6 +497,7 @@ escape_char (gchar *str, gchar ch)
 gboolean
 check_complete (GtkEntryCompletion *c, const gchar *key, GtkTreeIter *iter, gpointer data)
 {
+  static YadMatcher *m = NULL;
   gchar *value = NULL;
   GtkTreeModel *model = gtk_entry_completion_get_model (c);
   gboolean found = FALSE;
@@ -593,50 +505,26 @@ check_complete (GtkEntryCompletion *c, const gchar *key, GtkTreeIter *iter, gpoi
   if (!model || !key || !key[0])
     return FALSE;
 
-  gtk_tree_model_get (model, iter, 0, &value, -1);
+  /* use index of items model */
+  if (g_object_get_data (G_OBJECT (model), "yad-items"))
+    return items_match (model, key, iter);
 
-  if (value)
+  /* prepare matcher once for all rows */
+  if (!m || strcmp (m->key, key) != 0)
     {
-      gchar **words = NULL;
-      guint i = 0;
+      if (m)
+        matcher_free (m);
+      m = matcher_new (key);
+    }
 
-      switch (options.common_data.complete)
-        {
-        case YAD_COMPLETE_ANY:
-          words = g_strsplit_set (key, " \t", -1);
-          while (words[i])
-            {
-              if (strcasestr (value, words[i]) != NULL)
-                {
-                  /* found one of the words */
-                  found = TRUE;
-                  break;
-                }
-              i++;
-            }
-          break;
-        case YAD_COMPLETE_ALL:
-          words = g_strsplit_set (key, " \t", -1);
-          found = TRUE;
-          while (words[i])
-            {
-              if (strcasestr (value, words[i]) == NULL)
-                {
-                  /* not found one of the words */
-                  found = FALSE;
-                  break;
-                }
-              i++;
-            }
-          break;
-        case YAD_COMPLETE_REGEX:
-          found = g_regex_match_simple (key, value, G_REGEX_CASELESS | G_REGEX_OPTIMIZE, G_REGEX_MATCH_NOTEMPTY);
-          break;
-        default: ;
-        }
+  gtk_tree_model_get (model, iter, 0, &value, -1);
 
-      if (words)
-        g_strfreev (words);
+  if (value)
+    {
+      gchar *fvalue = fold_str (value);
+      found = matcher_match (m, fvalue);
+      g_free (fvalue);
+      g_free (value);
     }
 
   return found;
@@ -772,6 +660,21 @@ print_bool_val (gboolean val)
   return ret;
 }
 
+/* wrap command with interpreter if needed */
+gchar *
+get_full_cmd (gchar *cmd)
+{
+  if (options.data.use_interp)
+    {
+      if (g_strstr_len (options.data.interp, -1, "%s") != NULL)
+        return g_strdup_printf (options.data.interp, cmd);
+      else
+        return g_strdup_printf ("%s %s", options.data.interp, cmd);
+    }
+
+  return g_strdup (cmd);
+}
+
 typedef struct {
   gchar *cmd;
   gchar **out;
@@ -802,15 +705,7 @@ run_command_sync (gchar *cmd, gchar **out, GtkWidget *w)
 
   d = g_new0 (RunData, 1);
 
-  if (options.data.use_interp)
-    {
-      if (g_strstr_len (options.data.interp, -1, "%s") != NULL)
-        d->cmd = g_strdup_printf (options.data.interp, cmd);
-      else
-        d->cmd = g_strdup_printf ("%s %s", options.data.interp, cmd);
-    }
-  else
-    d->cmd = g_strdup (cmd);
+  d->cmd = get_full_cmd (cmd);
   d->out = out;
 
   if (w)
@@ -841,15 +736,7 @@ run_command_async (gchar *cmd)
   gchar *full_cmd = NULL;
   GError *err = NULL;
 
-  if (options.data.use_interp)
-    {
-      if (g_strstr_len (options.data.interp, -1, "%s") != NULL)
-        full_cmd = g_strdup_printf (options.data.interp, cmd);
-      else
-        full_cmd = g_strdup_printf ("%s %s", options.data.interp, cmd);
-    }
-  else
-    full_cmd = g_strdup (cmd);
+  full_cmd = get_full_cmd (cmd);
 
   if (!g_spawn_command_line_async (full_cmd, &err))
     {
@@ -861,6 +748,57 @@ run_command_async (gchar *cmd)
   g_free (full_cmd);
 }
 
+typedef struct {
+  gchar *cmd;
+  gchar *out;
+  gint ret;
+  YadRunCallback cb;
+  gpointer data;
+} RunCbData;
+
+static gboolean
+run_cb_done (RunCbData *d)
+{
+  d->cb (d->ret, d->out, d->data);
+
+  g_free (d->out);
+  g_free (d->cmd);
+  g_free (d);
+
+  return FALSE;
+}
+
+static void
+run_cb_thread (RunCbData *d)
+{
+  GError *err = NULL;
+
+  if (!g_spawn_command_line_sync (d->cmd, &d->out, NULL, NULL, &err))
+    {
+      if (options.debug)
+        g_printerr (_("WARNING: Run command failed: %s\n"), err->message);
+      g_error_free (err);
+      d->ret = -1;
+    }
+
+  /* pass result to the main loop */
+  g_idle_add ((GSourceFunc) run_cb_done, d);
+}
+
+/* run command in background and call cb with its output from the main loop */
+void
+run_command_cb (gchar *cmd, YadRunCallback cb, gpointer data)
+{
+  RunCbData *d;
+
+  d = g_new0 (RunCbData, 1);
+  d->cmd = get_full_cmd (cmd);
+  d->cb = cb;
+  d->data = data;
+
+  g_thread_unref (g_thread_new ("run_cb", (GThreadFunc) run_cb_thread, d));
+}
+
 #if GTK_CHECK_VERSION(3,0,0)
 gchar *
 pango_to_css (gchar *font)
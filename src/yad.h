@@ -189,6 +189,15 @@ typedef enum {
   YAD_BOOL_FMT_1
 } YadBoolFormat;
 
+typedef struct {
+  YadCompletionType type;
+  gchar *key;
+  gchar *fkey;          /* case-folded key */
+  gchar **words;        /* case-folded words for any and all types */
+  guint n_words;
+  GRegex *regex;
+} YadMatcher;
+
 typedef struct {
   gchar *name;
   gchar *cmd;
@@ -325,6 +334,7 @@ typedef struct {
   gboolean output_by_row;
   guint focus_field;
   gboolean cycle_read;
+  gboolean keyed_read;
   gboolean align_buttons;
   gchar *changed_action;
   gboolean homogeneous;
@@ -376,6 +386,8 @@ typedef struct {
   gint sep_column;
   gchar *sep_value;
   guint limit;
+  gint key_column;
+  gboolean snapshot;
   gchar *editable_cols;
   gint wrap_width;
   gchar *wrap_cols;
@@ -384,8 +396,13 @@ typedef struct {
   gchar *dclick_action;
   gchar *select_action;
   gchar *row_action;
+  gchar *expand_cmd;
+  gchar *page_cmd;
+  guint page_size;
+  guint max_pages;
   gboolean tree_expanded;
   gboolean regex_search;
+  gboolean filter_bar;
   gboolean clickable;
   gboolean no_selection;
   gboolean add_on_top;
@@ -417,6 +434,9 @@ typedef struct {
 typedef struct {
   YadPictureType size;
   gint inc;
+  gboolean slideshow;
+  gint interval;
+  gint preload;
 } YadPictureData;
 
 typedef struct {
@@ -490,6 +510,7 @@ typedef struct {
   gboolean listen;
   gboolean preview;
   gboolean large_preview;
+  gboolean prefetch_preview;
   gboolean show_hidden;
   gboolean quoted_output;
   gboolean num_output;
@@ -643,6 +664,8 @@ void dnd_init (GtkWidget *w);
 gint yad_notification_run (void);
 #endif
 gint yad_print_run (void);
+void print_text_buffer (GtkTextBuffer *buf, GtkWindow *parent);
+void print_tree_view (GtkTreeView *view, GtkWindow *parent);
 gint yad_about (void);
 
 gboolean yad_send_notify (gboolean);
@@ -654,6 +677,7 @@ void read_settings (void);
 void write_settings (void);
 
 void update_preview (GtkFileChooser *chooser, GtkWidget *p);
+void prefetch_previews (GtkFileChooser *chooser, gpointer data);
 
 GdkPixbuf *get_pixbuf (gchar *name, YadIconSize size, gboolean force);
 #if GTK_CHECK_VERSION(3,0,0)
@@ -673,13 +697,26 @@ gchar *escape_char (gchar *str, gchar ch);
 
 gboolean check_complete (GtkEntryCompletion *c, const gchar *key, GtkTreeIter *iter, gpointer data);
 
+GtkTreeModel *create_items_model (gchar **items);
+GtkTreeModel *get_items_model (const gchar *str, gint *def);
+gboolean items_match (GtkTreeModel *model, const gchar *key, GtkTreeIter *iter);
+
+gchar *fold_str (const gchar *str);
+YadMatcher *matcher_new (const gchar *key);
+void matcher_free (YadMatcher *m);
+gboolean matcher_match (YadMatcher *m, const gchar *text);
+
 void parse_geometry ();
 
 gboolean get_bool_val (gchar *str);
 gchar *print_bool_val (gboolean val);
 
+typedef void (*YadRunCallback) (gint ret, gchar *out, gpointer data);
+
+gchar *get_full_cmd (gchar *cmd);
 gint run_command_sync (gchar *cmd, gchar **out, GtkWidget *w);
 void run_command_async (gchar *cmd);
+void run_command_cb (gchar *cmd, YadRunCallback cb, gpointer data);
 
 #if GTK_CHECK_VERSION(3,0,0)
 gchar *pango_to_css (gchar *font);